@@ -5,13 +5,31 @@
 #ifndef LOCK_FREE_STACK_H
 #define LOCK_FREE_STACK_H
 #include <atomic>
+#include <cstddef>
 #include <memory>
+#include <new>
 #include <thread>
 #include <stdexcept>
 
 unsigned int constexpr max_hazard_pointers = 100;
 
-struct HazardPointer
+// Each hazard pointer occupies its own cache line, so that publishing a pointer does not invalidate
+// the hazard pointers of other threads. GCC warns that std::hardware_destructive_interference_size depends on the
+// tuning flags; it only affects the layout of this header, so the warning is silenced.
+#ifdef __cpp_lib_hardware_interference_size
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+#endif
+std::size_t constexpr hazard_pointer_alignment = std::hardware_destructive_interference_size;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+std::size_t constexpr hazard_pointer_alignment = 64;
+#endif
+
+struct alignas(hazard_pointer_alignment) HazardPointer
 {
     std::atomic<std::thread::id> id{std::thread::id()};
     std::atomic<void*> pointer{nullptr};
@@ -83,7 +101,7 @@ void do_delete(void* pointer)
 struct data_to_reclaim
 {
     void* data;
-    std::function<void(void*)> deleter;
+    void (*deleter)(void*);
     data_to_reclaim* next;
 
     template <typename T>
@@ -133,7 +151,85 @@ inline void delete_nodes_with_no_hazards()
     }
 }
 
-template <typename T>
+// Retire list on top of the global reclaim list above.
+template <typename Node>
+class ReclaimLaterList
+{
+public:
+    void retire(Node* node)
+    {
+        // Can we delete `node` right now, or do we have to defer?
+        if (outstanding_hazard_pointers_for(node))
+        {
+            // Some other thread still has `node` pinned in its hazard slot.
+            // We cannot delete it yet or we’d risk dangling-pointer accesses.
+            reclaim_later(node);
+        }
+        else
+        {
+            delete node;
+        }
+        // Sweep through any previously-deferred nodes
+        delete_nodes_with_no_hazards();
+    }
+};
+
+// Reclamation policy using the hazard pointers of this file. Any policy providing a Guard with
+// protect()/reset() and a retire_list can be plugged in instead, e.g. EpochReclamation from
+// lock_free_data_structures/epoch_reclamation.h.
+struct SharedPtrHazardPointerReclamation
+{
+    class Guard
+    {
+        std::atomic<void*>& hazard_pointer;
+
+    public:
+        Guard() : hazard_pointer(get_hazard_pointer())
+        {
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        ~Guard()
+        {
+            reset();
+        }
+
+        // Problem: between the moment we load head into old_head and the moment we store that pointer in our hazard
+        // slot, another thread could have popped and reclaimed that node -- leaving us with a dangling pointer.
+        // Solution:
+        // Load old_head
+        // Immediately publish it in hp
+        // Reload head to confirm it didn’t change in the meantime
+        // If it did change, repeat -- his guarantees that whenever you hold hazard_pointer = old_head,
+        // that pointer will remain valid until you clear hazard_pointer.
+        template <typename Node>
+        Node* protect(const std::atomic<Node*>& source)
+        {
+            Node* pointer = source.load();
+            Node* temp_node = nullptr;
+            do
+            {
+                temp_node = pointer;
+                hazard_pointer.store(pointer); // accessing pointer now
+                pointer = source.load(); // see if source changed
+            }
+            while (pointer != temp_node);
+            return pointer;
+        }
+
+        void reset()
+        {
+            hazard_pointer.store(nullptr);
+        }
+    };
+
+    template <typename Node>
+    using retire_list = ReclaimLaterList<Node>;
+};
+
+template <typename T, typename Reclamation = SharedPtrHazardPointerReclamation>
 class LockFreeStackSharedPtr
 {
 private:
@@ -158,6 +254,7 @@ private:
     // We need an atomic compare-and-swap on head so that two pushes or pops can race but only one “wins” at a time,
     // without ever taking a lock.
     std::atomic<Node*> head;
+    typename Reclamation::template retire_list<Node> retire_list;
 
 public:
     void push(const T& new_value)
@@ -171,23 +268,16 @@ public:
 
     std::shared_ptr<T> top()
     {
-        auto& hazard_pointer = get_hazard_pointer();
-        Node* current = nullptr;
-        // Loop until we load the same head twice under our hazard pointer
-        do
-        {
-            current = head.load(std::memory_order_acquire);
-            hazard_pointer.store(current);
-            // retry if head changed under us
-        }
-        while (current && head.load(std::memory_order_acquire) != current);
+        typename Reclamation::Guard guard;
+        // Loop until we load the same head twice under our protection
+        Node* current = guard.protect(head);
 
         std::shared_ptr<T> result;
         if (current)
         {
             result = current->data; // atomic bump of the shared_ptr control block
         }
-        hazard_pointer.store(nullptr);
+        guard.reset();
         return result; // empty shared_ptr if stack was empty
     }
 
@@ -198,51 +288,23 @@ public:
     // and only delete nodes not currently announced.
     std::shared_ptr<T> pop()
     {
-        auto& hazard_pointer = get_hazard_pointer();
-        Node* old_head = head.load();
-
-        // Problem: between the moment we load head into old_head and the moment we store that pointer in our hazard
-        // slot, another thread could have popped and reclaimed that node -- leaving us with a dangling pointer.
-        // Solution:
-        // Load old_head
-        // Immediately publish it in hp
-        // Reload head to confirm it didn’t change in the meantime
-        // If it did change, repeat -- his guarantees that whenever you hold hazard_pointer = old_head,
-        // that pointer will remain valid until you clear hazard_pointer.
-        do
-        {
-            Node* temp_node = nullptr;
-            do
-            {
-                temp_node = old_head;
-                hazard_pointer.store(old_head); // accessing old_head now
-                old_head = head.load();  // see if head changed
-            }
-            while (old_head != temp_node);
-        }
+        typename Reclamation::Guard guard;
+        Node* old_head = guard.protect(head);
         // Problem: multiple threads might race to pop the same node. You must ensure only one wins the unlink, and the others retry.
         // Solution: a CAS on head from old_head to old_head->next:
         while (old_head &&
-            !head.compare_exchange_strong(old_head, old_head->next));
-        hazard_pointer.store(nullptr);
+            !head.compare_exchange_strong(old_head, old_head->next))
+        {
+            old_head = guard.protect(head);
+        }
+        guard.reset();
         std::shared_ptr<T> result;
         if (old_head)
         {
             // Get the payload
             result.swap(old_head->data);
-            // Can we delete `old_head` right now, or do we have to defer?
-            if (outstanding_hazard_pointers_for(old_head))
-            {
-                // Some other thread still has `old_head` pinned in its hazard slot.
-                // We cannot delete it yet or we’d risk dangling-pointer accesses.
-                reclaim_later(old_head);
-            }
-            else
-            {
-                delete old_head;
-            }
-            // Sweep through any previously-deferred nodes
-            delete_nodes_with_no_hazards();
+            // Hand the node over to the reclamation policy
+            retire_list.retire(old_head);
         }
         return result;
     }
@@ -11,6 +11,7 @@
 #include <thread>
 #include <vector>
 #include "lock_free_stack_shared_ptr.h"
+#include "../lock_free_data_structures/epoch_reclamation.h"
 
 TEST(LockFreeStackSharedPtrTest, MultiProducerMultiConsumer)
 {
@@ -87,6 +88,53 @@ TEST(LockFreeStackSharedPtrTest, MultiProducerMultiConsumer)
     EXPECT_EQ(results, expected);
 }
 
+TEST(LockFreeStackSharedPtrTest, EpochReclamationMultiProducerMultiConsumer)
+{
+    LockFreeStackSharedPtr<int, EpochReclamation> stack;
+    constexpr int producer_count = 4;
+    constexpr int consumer_count = 4;
+    constexpr int operations = 1000;
+    constexpr int item_count = producer_count * operations;
+
+    std::vector<std::thread> threads;
+    for (int thread_count = 0; thread_count < producer_count; ++thread_count)
+    {
+        threads.emplace_back([&, thread_count]
+        {
+            for (int i = 0; i < operations; ++i)
+            {
+                stack.push(thread_count * operations + i);
+            }
+        });
+    }
+
+    std::atomic<int> consumed_count{0};
+    std::atomic<long long> consumed_sum{0};
+    for (int c = 0; c < consumer_count; ++c)
+    {
+        threads.emplace_back([&]
+        {
+            while (consumed_count.load() < item_count)
+            {
+                if (auto shared_ptr = stack.pop())
+                {
+                    consumed_sum += *shared_ptr;
+                    ++consumed_count;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_EQ(consumed_count.load(), item_count);
+    EXPECT_EQ(consumed_sum.load(), static_cast<long long>(item_count) * (item_count - 1) / 2);
+    EXPECT_EQ(stack.pop(), nullptr);
+}
 
 //–– Single‐threaded correctness of push / top / pop ––
 TEST(LockFreeStackSharedPtrTest, SingleThreadPushPop) {
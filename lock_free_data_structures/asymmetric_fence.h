@@ -0,0 +1,65 @@
+//
+// Created by andreas on 18.10.26.
+//
+
+#ifndef ASYMMETRIC_FENCE_H
+#define ASYMMETRIC_FENCE_H
+#include <atomic>
+#if defined(__linux__)
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Asymmetric fences split a store-load fence between a frequent and a rare side:
+// the frequent side (readers publishing hazard pointers) only needs a compiler fence, while the rare side
+// (reclaimers scanning the hazard pointers) forces a full memory barrier on every CPU running a thread of this
+// process via the Linux membarrier system call. Without membarrier both sides fall back to seq_cst fences.
+
+/**
+ * @brief Register the process for expedited private membarriers, once.
+ * @return True if the heavy fence can be issued with membarrier.
+ */
+inline bool membarrier_available()
+{
+#if defined(__linux__) && defined(SYS_membarrier)
+    static const bool available = []
+    {
+        const long commands = syscall(SYS_membarrier, MEMBARRIER_CMD_QUERY, 0, 0);
+        if (commands < 0 || !(commands & MEMBARRIER_CMD_PRIVATE_EXPEDITED))
+            return false;
+        return syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+    }();
+    return available;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Fence of the frequent side. Only prevents compiler reordering if membarrier is available.
+ */
+inline void asymmetric_thread_fence_light()
+{
+    if (membarrier_available())
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    else
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+/**
+ * @brief Fence of the rare side. Serializes all threads of the process that issued a light fence.
+ */
+inline void asymmetric_thread_fence_heavy()
+{
+#if defined(__linux__) && defined(SYS_membarrier)
+    if (membarrier_available())
+    {
+        syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+        return;
+    }
+#endif
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+#endif //ASYMMETRIC_FENCE_H
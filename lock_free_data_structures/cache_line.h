@@ -0,0 +1,26 @@
+//
+// Created by andreas on 18.10.26.
+//
+
+#ifndef CACHE_LINE_H
+#define CACHE_LINE_H
+#include <cstddef>
+#include <new>
+
+// Minimum distance of two objects written by different threads, such that they do not share a cache line.
+// The value of std::hardware_destructive_interference_size depends on the tuning flags, which GCC warns about;
+// it is only used for the layout of these header-only data structures, so the warning is silenced.
+#ifdef __cpp_lib_hardware_interference_size
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+#endif
+constexpr std::size_t cache_line_size = std::hardware_destructive_interference_size;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+constexpr std::size_t cache_line_size = 64;
+#endif
+
+#endif //CACHE_LINE_H
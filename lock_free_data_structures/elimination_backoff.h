@@ -0,0 +1,164 @@
+//
+// Created by andreas on 18.10.26.
+//
+
+#ifndef ELIMINATION_BACKOFF_H
+#define ELIMINATION_BACKOFF_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "cache_line.h"
+
+/// Maximum number of exchange slots of an EliminationArray.
+constexpr std::size_t elimination_max_width = 16;
+/// Number of polls a pusher waits in its slot for a popper before it withdraws.
+constexpr std::size_t elimination_push_spins = 128;
+/// Number of polls a popper waits for a pusher to show up in its slot.
+constexpr std::size_t elimination_pop_spins = 32;
+
+/**
+ * @class EliminationArray
+ * @brief Exchange slots where a push and a pop that collided on the head of a stack cancel each other out.
+ *
+ * A push followed by a pop leaves the stack unchanged, so the two operations can complete without touching the
+ * head at all. After a failed CAS on the head, a pusher parks its node in a random slot and waits for a popper;
+ * a popper checks a random slot and takes whatever node it finds there.
+ *
+ * A slot holds the parked node; a popper claims the node by setting the lowest bit of the slot. Only the pusher
+ * that parked a node clears its slot again, so a node can never be claimed twice, even if it is freed and
+ * reallocated in the meantime.
+ *
+ * The number of slots in use adapts to the contention: it doubles when a pusher finds its slot occupied and halves
+ * when a pusher waited in vain.
+ */
+template <typename Node>
+class EliminationArray
+{
+    static constexpr std::uintptr_t claimed = 1;
+
+    struct alignas(cache_line_size) Slot
+    {
+        std::atomic<std::uintptr_t> value{0};
+    };
+
+    Slot slots[elimination_max_width];
+    alignas(cache_line_size) std::atomic<std::size_t> width{1};
+
+    static std::size_t random_index()
+    {
+        // xorshift, seeded with the address of the thread-local state so threads spread out
+        thread_local std::uint32_t state = static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(&state) >> 4) | 1;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    Slot& random_slot()
+    {
+        return slots[random_index() & (width.load(std::memory_order_relaxed) - 1)];
+    }
+
+    void grow()
+    {
+        std::size_t current = width.load(std::memory_order_relaxed);
+        if (current < elimination_max_width)
+            width.compare_exchange_weak(current, current * 2, std::memory_order_relaxed);
+    }
+
+    void shrink()
+    {
+        std::size_t current = width.load(std::memory_order_relaxed);
+        if (current > 1)
+            width.compare_exchange_weak(current, current / 2, std::memory_order_relaxed);
+    }
+
+public:
+    /**
+     * @brief Offer node to a concurrent pop.
+     * @return True if a popper took the node; the push is complete and the node belongs to the popper.
+     */
+    bool try_push(Node* node)
+    {
+        Slot& slot = random_slot();
+        const auto parked = reinterpret_cast<std::uintptr_t>(node);
+        std::uintptr_t expected = 0;
+        if (!slot.value.compare_exchange_strong(expected, parked, std::memory_order_release,
+                                                std::memory_order_relaxed))
+        {
+            grow();
+            return false;
+        }
+        for (std::size_t spin = 0; spin < elimination_push_spins; ++spin)
+        {
+            if (slot.value.load(std::memory_order_acquire) != parked)
+            {
+                slot.value.store(0, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        // Withdraw; failing to do so means a popper claimed the node in the meantime.
+        expected = parked;
+        if (slot.value.compare_exchange_strong(expected, 0, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            shrink();
+            return false;
+        }
+        slot.value.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Take the node of a concurrent push.
+     * @return The node, which now belongs to the caller, or nullptr if no pusher showed up.
+     */
+    Node* try_pop()
+    {
+        Slot& slot = random_slot();
+        for (std::size_t spin = 0; spin < elimination_pop_spins; ++spin)
+        {
+            std::uintptr_t parked = slot.value.load(std::memory_order_relaxed);
+            if (parked == 0 || (parked & claimed))
+                continue;
+            if (slot.value.compare_exchange_strong(parked, parked | claimed, std::memory_order_acq_rel,
+                                                   std::memory_order_relaxed))
+                return reinterpret_cast<Node*>(parked);
+        }
+        return nullptr;
+    }
+};
+
+/**
+ * @class NoElimination
+ * @brief Elimination array that never pairs operations, i.e. plain retries on the head.
+ */
+template <typename Node>
+class NoElimination
+{
+public:
+    bool try_push(Node*)
+    {
+        return false;
+    }
+
+    Node* try_pop()
+    {
+        return nullptr;
+    }
+};
+
+/// Backoff policy of the stacks: retry on the head immediately.
+struct NoBackoff
+{
+    template <typename Node>
+    using elimination_array = NoElimination<Node>;
+};
+
+/// Backoff policy of the stacks: try to eliminate a push against a pop after every failed CAS on the head.
+struct EliminationBackoff
+{
+    template <typename Node>
+    using elimination_array = EliminationArray<Node>;
+};
+
+#endif //ELIMINATION_BACKOFF_H
@@ -0,0 +1,335 @@
+//
+// Created by andreas on 18.10.26.
+//
+
+#ifndef EPOCH_RECLAMATION_H
+#define EPOCH_RECLAMATION_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "cache_line.h"
+
+/// Number of retired objects a thread collects before it tries to advance the global epoch
+/// and to free the objects of its limbo list that became unreachable.
+constexpr std::size_t epoch_collect_threshold = 64;
+
+/**
+ * @struct RetiredObject
+ * @brief Type-erased entry of a limbo list.
+ *
+ * Remembers the retired pointer, how to delete it and the global epoch at the time of retirement.
+ */
+struct RetiredObject
+{
+    void* pointer;
+    void (*deleter)(void*);
+    std::uint64_t epoch;
+};
+
+/**
+ * @class EpochDomain
+ * @brief Global state of the epoch-based reclamation (EBR) scheme.
+ *
+ * Every thread announces the global epoch it observed when entering a critical section. The global epoch
+ * can only be advanced once all pinned threads have announced the current epoch. An object retired in epoch e
+ * is therefore unreachable for every thread as soon as the global epoch reached e + 2.
+ */
+class EpochDomain
+{
+public:
+    /**
+     * @struct ThreadRecord
+     * @brief Per-thread epoch announcement.
+     *
+     * Records are never freed while the domain lives; a record released by an exiting thread is reused
+     * by the next thread that registers. Each record occupies its own cache line, as it is written on every pin.
+     */
+    struct alignas(cache_line_size) ThreadRecord
+    {
+        /// Announced epoch shifted left by one. The lowest bit is set while the thread is pinned.
+        std::atomic<std::uint64_t> announcement{0};
+        std::atomic<bool> in_use{false};
+        ThreadRecord* next{nullptr};
+    };
+
+    EpochDomain() = default;
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    ~EpochDomain()
+    {
+        // All threads are gone at this point, hence everything left over can be freed.
+        OrphanBatch* batch = orphans.exchange(nullptr);
+        while (batch)
+        {
+            for (const auto& retired : batch->objects)
+                retired.deleter(retired.pointer);
+            OrphanBatch* next = batch->next;
+            delete batch;
+            batch = next;
+        }
+        ThreadRecord* record = records.exchange(nullptr);
+        while (record)
+        {
+            ThreadRecord* next = record->next;
+            delete record;
+            record = next;
+        }
+    }
+
+    /**
+     * @brief Claim a free thread record or append a new one to the record list.
+     */
+    ThreadRecord* acquire_record()
+    {
+        for (ThreadRecord* record = records.load(std::memory_order_acquire); record; record = record->next)
+        {
+            if (bool expected = false; !record->in_use.load(std::memory_order_relaxed) &&
+                record->in_use.compare_exchange_strong(expected, true))
+                return record;
+        }
+        auto* record = new ThreadRecord;
+        record->in_use.store(true, std::memory_order_relaxed);
+        record->next = records.load(std::memory_order_relaxed);
+        while (!records.compare_exchange_weak(record->next, record, std::memory_order_release,
+                                              std::memory_order_relaxed));
+        return record;
+    }
+
+    void release_record(ThreadRecord* record)
+    {
+        record->announcement.store(0, std::memory_order_release);
+        record->in_use.store(false, std::memory_order_release);
+    }
+
+    std::uint64_t current_epoch() const
+    {
+        return global_epoch.load(std::memory_order_seq_cst);
+    }
+
+    /**
+     * @brief Announce the current global epoch for the given record.
+     *
+     * The seq_cst fence orders the announcement before every subsequent load of shared pointers.
+     */
+    void pin(ThreadRecord* record)
+    {
+        const std::uint64_t epoch = global_epoch.load(std::memory_order_relaxed);
+        record->announcement.store((epoch << 1) | 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    void unpin(ThreadRecord* record)
+    {
+        record->announcement.store(record->announcement.load(std::memory_order_relaxed) & ~std::uint64_t{1},
+                                   std::memory_order_release);
+    }
+
+    /**
+     * @brief Advance the global epoch if every pinned thread has observed the current one.
+     * @return The global epoch after the attempt.
+     */
+    std::uint64_t try_advance()
+    {
+        std::uint64_t epoch = global_epoch.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (ThreadRecord* record = records.load(std::memory_order_acquire); record; record = record->next)
+        {
+            if (!record->in_use.load(std::memory_order_relaxed))
+                continue;
+            const std::uint64_t announcement = record->announcement.load(std::memory_order_relaxed);
+            if ((announcement & 1) && (announcement >> 1) != epoch)
+                return epoch;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (global_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_release,
+                                                 std::memory_order_relaxed))
+            return epoch + 1;
+        return epoch;
+    }
+
+    /**
+     * @brief Hand the limbo list of an exiting thread over to the domain.
+     */
+    void add_orphans(std::vector<RetiredObject>&& objects)
+    {
+        auto* batch = new OrphanBatch{std::move(objects), orphans.load(std::memory_order_relaxed)};
+        while (!orphans.compare_exchange_weak(batch->next, batch, std::memory_order_release,
+                                              std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief Move all orphaned objects into the limbo list of the calling thread.
+     */
+    void adopt_orphans(std::vector<RetiredObject>& limbo)
+    {
+        if (!orphans.load(std::memory_order_relaxed))
+            return;
+        OrphanBatch* batch = orphans.exchange(nullptr, std::memory_order_acquire);
+        while (batch)
+        {
+            limbo.insert(limbo.end(), batch->objects.begin(), batch->objects.end());
+            OrphanBatch* next = batch->next;
+            delete batch;
+            batch = next;
+        }
+    }
+
+private:
+    struct OrphanBatch
+    {
+        std::vector<RetiredObject> objects;
+        OrphanBatch* next;
+    };
+
+    // The global epoch is read on every pin, keep it away from the list heads that are written on registration.
+    alignas(cache_line_size) std::atomic<std::uint64_t> global_epoch{0};
+    alignas(cache_line_size) std::atomic<ThreadRecord*> records{nullptr};
+    std::atomic<OrphanBatch*> orphans{nullptr};
+};
+
+/// The domain shared by all epoch-protected data structures.
+inline EpochDomain epoch_domain;
+
+/**
+ * @class EpochThreadState
+ * @brief Thread-local part of the EBR scheme: the announcement record, pin depth and limbo list.
+ */
+class EpochThreadState
+{
+    EpochDomain::ThreadRecord* record;
+    std::size_t pin_depth{};
+    std::size_t retired_since_collect{};
+    std::vector<RetiredObject> limbo;
+
+public:
+    EpochThreadState() : record(epoch_domain.acquire_record())
+    {
+    }
+
+    EpochThreadState(const EpochThreadState&) = delete;
+    EpochThreadState& operator=(const EpochThreadState&) = delete;
+
+    ~EpochThreadState()
+    {
+        collect();
+        if (!limbo.empty())
+            epoch_domain.add_orphans(std::move(limbo));
+        epoch_domain.release_record(record);
+    }
+
+    void pin()
+    {
+        if (pin_depth++ == 0)
+            epoch_domain.pin(record);
+    }
+
+    void unpin()
+    {
+        if (--pin_depth == 0)
+            epoch_domain.unpin(record);
+    }
+
+    void retire(void* pointer, void (*deleter)(void*))
+    {
+        limbo.push_back({pointer, deleter, epoch_domain.current_epoch()});
+        if (++retired_since_collect >= epoch_collect_threshold)
+            collect();
+    }
+
+    /**
+     * @brief Try to advance the global epoch and free every object retired at least two epochs ago.
+     */
+    void collect()
+    {
+        retired_since_collect = 0;
+        epoch_domain.adopt_orphans(limbo);
+        const std::uint64_t epoch = epoch_domain.try_advance();
+        std::size_t kept{};
+        for (auto& retired : limbo)
+        {
+            if (retired.epoch + 2 <= epoch)
+                retired.deleter(retired.pointer);
+            else
+                limbo[kept++] = retired;
+        }
+        limbo.resize(kept);
+    }
+};
+
+/**
+ * @brief Get the calling thread's EBR state.
+ */
+inline EpochThreadState& get_epoch_state()
+{
+    thread_local EpochThreadState state;
+    return state;
+}
+
+/**
+ * @class EpochRetireList
+ * @brief Retire list facade that hands nodes over to the calling thread's limbo list.
+ */
+template <typename Node, typename Deleter = std::default_delete<Node>>
+class EpochRetireList
+{
+public:
+    void retire(Node* node)
+    {
+        get_epoch_state().retire(node, [](void* pointer) { Deleter{}(static_cast<Node*>(pointer)); });
+    }
+};
+
+/**
+ * @struct EpochReclamation
+ * @brief Reclamation policy based on epochs.
+ *
+ * A Guard pins the calling thread for its whole lifetime, so protecting a pointer is a plain acquire load.
+ * Compared to hazard pointers there is no publish/validate loop per pointer and no scan of all slots per
+ * retired node; in exchange a thread stalled inside a critical section delays the reclamation of all nodes.
+ */
+struct EpochReclamation
+{
+    class Guard
+    {
+        EpochThreadState& state;
+
+    public:
+        // The slot is only there for compatibility with hazard pointer guards, all guards share the pin.
+        explicit Guard(std::size_t = 0) : state(get_epoch_state())
+        {
+            state.pin();
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        ~Guard()
+        {
+            state.unpin();
+        }
+
+        template <typename T>
+        T* protect(const std::atomic<T*>& source)
+        {
+            return source.load(std::memory_order_acquire);
+        }
+
+        template <typename T>
+        void publish(T*)
+        {
+        }
+
+        void reset()
+        {
+        }
+    };
+
+    template <typename Node, typename Deleter = std::default_delete<Node>>
+    using retire_list = EpochRetireList<Node, Deleter>;
+};
+
+#endif //EPOCH_RECLAMATION_H
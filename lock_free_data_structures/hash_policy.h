@@ -0,0 +1,67 @@
+//
+// Created by andreas on 18.10.26.
+//
+
+#ifndef HASH_POLICY_H
+#define HASH_POLICY_H
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Hashers for the open addressing hash tables. A hasher is a default constructible function object mapping a key
+// to a std::size_t; the tables reduce that value to an index with a mask if their capacity is a power of two,
+// and with a modulo otherwise.
+
+/**
+ * @struct MixingHash
+ * @brief Integer hash with the 64-bit finalizer of MurmurHash3.
+ *
+ * libstdc++'s std::hash of an integer is the identity, so consecutive keys, e.g. the cells of a dynamic programming
+ * table, land in consecutive slots and merge into long linear probing runs; keys sharing their low bits all hit the
+ * same slot of a power-of-two table. The finalizer makes every output bit depend on every input bit.
+ */
+template <typename KeyType>
+struct MixingHash
+{
+    std::size_t operator()(KeyType key) const noexcept
+    {
+        auto x = static_cast<std::uint64_t>(key);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return static_cast<std::size_t>(x);
+    }
+};
+
+/// Hasher of the standard library, i.e. the identity for integers with libstdc++. Only meant for comparisons.
+template <typename KeyType>
+using IdentityHash = std::hash<KeyType>;
+
+/**
+ * @brief Reduce a hash to an index smaller than capacity.
+ */
+template <std::size_t Capacity>
+constexpr std::size_t reduce_hash(std::size_t hash)
+{
+    if constexpr (std::has_single_bit(Capacity))
+        return hash & (Capacity - 1);
+    else
+        return hash % Capacity;
+}
+
+/**
+ * @brief Linear probing step: the index following index, wrapping around at capacity.
+ */
+template <std::size_t Capacity>
+constexpr std::size_t next_probe(std::size_t index)
+{
+    if constexpr (std::has_single_bit(Capacity))
+        return (index + 1) & (Capacity - 1);
+    else
+        return index + 1 == Capacity ? 0 : index + 1;
+}
+
+#endif //HASH_POLICY_H
@@ -4,104 +4,184 @@
 
 #ifndef HAZARD_POINTER_H
 #define HAZARD_POINTER_H
+#include <atomic>
 #include <cstddef>
-#include <stdexcept>
+#include "cache_line.h"
 
-/// Maximum number of hazard pointers available globally.
-/// Each thread may claim one hazard pointer slot at a time.
-constexpr std::size_t max_hazard_pointers = 50;
+/// Number of hazard pointer slots in one record. Each thread owns one record, so it can protect
+/// this many pointers at the same time, e.g. predecessor and successor during a traversal.
+constexpr std::size_t hazard_pointer_slots = 5;
+
+/// Records are padded to a cache line so that publishing a hazard pointer does not invalidate
+/// the slots of other threads. Defining HAZARD_POINTER_PACKED_RECORDS packs them back-to-back instead,
+/// which is only meant to measure the effect of the padding.
+#ifndef HAZARD_POINTER_PACKED_RECORDS
+constexpr std::size_t hazard_pointer_record_alignment = cache_line_size;
+#else
+constexpr std::size_t hazard_pointer_record_alignment = alignof(std::atomic<void*>);
+#endif
 
 /**
- * @struct HazardPointer
- * @brief A single hazard pointer record.
+ * @struct HazardPointerRecord
+ * @brief The hazard pointer slots of one thread.
  *
- * Contains an owner thread identifier and a pointer to the protected object.
- */struct HazardPointer
+ * Records are linked into the registry of a HazardPointerDomain and are never freed while the domain lives.
+ * A record released by an exiting thread is reused by the next thread that needs one.
+ */
+struct alignas(hazard_pointer_record_alignment) HazardPointerRecord
 {
-    /// ID of the thread that currently owns this hazard pointer.
-    std::atomic<std::thread::id> id;
-    /// The actual pointer being protected.
+    /// The actual pointers being protected.
     /// Other threads must check all hazard pointers before reclaiming memory.
-    std::atomic<void*> pointer;
+    std::atomic<void*> slots[hazard_pointer_slots]{};
+    /// Whether a thread currently owns this record.
+    std::atomic<bool> active{false};
+    /// Next record in the registry, immutable once the record is published.
+    HazardPointerRecord* next{nullptr};
+};
+
+/**
+ * @class HazardPointerDomain
+ * @brief Growable lock-free registry of hazard pointer records.
+ *
+ * New records are pushed with a CAS onto the registry, so the number of threads using hazard pointers
+ * is not capped.
+ */
+class HazardPointerDomain
+{
+    std::atomic<HazardPointerRecord*> records{nullptr};
+    std::atomic<std::size_t> active_records{0};
+
+public:
+    HazardPointerDomain() = default;
+    HazardPointerDomain(const HazardPointerDomain&) = delete;
+    HazardPointerDomain& operator=(const HazardPointerDomain&) = delete;
+
+    ~HazardPointerDomain()
+    {
+        HazardPointerRecord* record = records.exchange(nullptr);
+        while (record)
+        {
+            HazardPointerRecord* next = record->next;
+            delete record;
+            record = next;
+        }
+    }
+
+    /**
+     * @brief Claim an inactive record or append a new one to the registry.
+     */
+    HazardPointerRecord* acquire_record()
+    {
+        active_records.fetch_add(1, std::memory_order_relaxed);
+        for (HazardPointerRecord* record = records.load(std::memory_order_acquire); record; record = record->next)
+        {
+            if (bool expected = false; !record->active.load(std::memory_order_relaxed) &&
+                record->active.compare_exchange_strong(expected, true))
+                return record;
+        }
+        auto* record = new HazardPointerRecord;
+        record->active.store(true, std::memory_order_relaxed);
+        record->next = records.load(std::memory_order_relaxed);
+        while (!records.compare_exchange_weak(record->next, record, std::memory_order_release,
+                                              std::memory_order_relaxed));
+        return record;
+    }
+
+    /**
+     * @brief Clear all slots of the record and make it available for other threads.
+     */
+    void release_record(HazardPointerRecord* record)
+    {
+        for (auto& slot : record->slots)
+            slot.store(nullptr);
+        record->active.store(false, std::memory_order_release);
+        active_records.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Number of slots owned by threads right now.
+     */
+    std::size_t active_slots() const
+    {
+        return active_records.load(std::memory_order_relaxed) * hazard_pointer_slots;
+    }
+
+    /**
+     * @brief Call function for every published (non-null) hazard pointer.
+     */
+    template <typename Function>
+    void for_each_hazard_pointer(Function&& function) const
+    {
+        for (HazardPointerRecord* record = records.load(std::memory_order_acquire); record; record = record->next)
+        {
+            if (!record->active.load(std::memory_order_acquire))
+                continue;
+            for (auto& slot : record->slots)
+            {
+                if (void* pointer = slot.load())
+                    function(pointer);
+            }
+        }
+    }
 };
 
-/// Global array of hazard pointer records. All threads share this pool.
-inline HazardPointer hazard_pointers[max_hazard_pointers];
+/// The registry shared by all hazard-pointer protected data structures.
+inline HazardPointerDomain hazard_pointer_domain;
 
 /**
  * @class HazardPointerOwner
- * @brief RAII wrapper to claim and release a hazard pointer slot.
+ * @brief RAII wrapper to claim and release a hazard pointer record.
  *
- * Upon construction, searches the global pool for an unused slot
- * and marks it with the current thread's ID. Upon destruction,
- * it clears the pointer and releases the slot back to the pool.
+ * Upon construction, claims a record of the domain for the current thread.
+ * Upon destruction, it clears all slots and releases the record back to the domain.
  */
 class HazardPointerOwner
 {
-    HazardPointer* hazard_pointer;
+    HazardPointerRecord* record;
 
 public:
     // Disable copy semantics; only one owner per thread.
     HazardPointerOwner(HazardPointerOwner const&) = delete;
     HazardPointerOwner operator=(HazardPointerOwner const&) = delete;
 
-     /**
-     * @brief Construct and claim an unused hazard pointer.
-     * @throws std::out_of_range if no slots are available.
-     */
-    HazardPointerOwner() : hazard_pointer(nullptr)
+    HazardPointerOwner() : record(hazard_pointer_domain.acquire_record())
     {
-        for (auto& hp : hazard_pointers)
-        {
-            // Try to install this thread's ID into an empty slot.
-            // If the id of hp is empty it has not yet been claimed
-            if (std::thread::id no_owner; hp.id.compare_exchange_strong(no_owner, std::this_thread::get_id()))
-            {
-                hazard_pointer = &hp;
-                break;
-            }
-        }
-        if (!hazard_pointer)
-        {
-            throw std::out_of_range("No hazard pointers available!");
-        }
     }
 
     /**
-     * @brief Access the underlying atomic pointer for protection.
+     * @brief Access one of the record's atomic pointers for protection.
+     * @param slot Index of the slot, smaller than hazard_pointer_slots.
      * @return Reference to the thread‑local atomic<void*> hazard pointer.
      */
-    std::atomic<void*>& get_pointer() const
+    std::atomic<void*>& get_pointer(std::size_t slot = 0) const
     {
-        return hazard_pointer->pointer;
+        return record->slots[slot];
     }
 
     /**
-     * @brief Release the hazard pointer and free the slot.
-     *
-     * Clears the pointer and resets the owner ID, making the slot
-     * available for other threads.
+     * @brief Release the record and with it all its slots.
      */
     ~HazardPointerOwner()
     {
-        hazard_pointer->pointer.store(nullptr);
-        hazard_pointer->id.store(std::thread::id());
+        hazard_pointer_domain.release_record(record);
     }
 };
 
 
 /**
- * @brief Get the calling thread's hazard pointer.
+ * @brief Get one of the calling thread's hazard pointers.
  *
  * Internally creates a thread‑local HazardPointerOwner, so each thread
- * only ever claims one slot.  Returns a reference to the protected pointer.
+ * only ever claims one record.  Returns a reference to the protected pointer.
+ * Different slots can be used to protect several nodes at once, e.g. hand-over-hand during a traversal.
  *
+ * @param slot Index of the slot, smaller than hazard_pointer_slots.
  * @return Reference to a thread‑local hazard pointer atomic.
  */
-inline std::atomic<void*>& get_hazard_pointer()
+inline std::atomic<void*>& get_hazard_pointer(std::size_t slot = 0)
 {
     thread_local HazardPointerOwner hazard;
-    return hazard.get_pointer();
+    return hazard.get_pointer(slot);
 }
 
 #endif //HAZARD_POINTER_H
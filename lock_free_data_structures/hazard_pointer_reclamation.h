@@ -0,0 +1,117 @@
+//
+// Created by andreas on 18.10.26.
+//
+
+#ifndef HAZARD_POINTER_RECLAMATION_H
+#define HAZARD_POINTER_RECLAMATION_H
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include "asymmetric_fence.h"
+#include "hazard_pointer.h"
+#include "retire_list.h"
+
+/**
+ * @struct BasicHazardPointerReclamation
+ * @brief Reclamation policy based on the calling thread's hazard pointers.
+ *
+ * A Guard publishes the pointer it protects and re-validates it against its source. Retired nodes are
+ * only deleted once no hazard pointer references them anymore.
+ *
+ * @tparam AsymmetricFence If true, publishing a hazard pointer is a relaxed store followed by a compiler-only
+ * fence and the retire list issues a process-wide membarrier before it scans the hazard pointers
+ * (see asymmetric_fence.h). This moves the cost of the store-load fence from every read to the rare scan.
+ */
+template <bool AsymmetricFence>
+struct BasicHazardPointerReclamation
+{
+    /**
+     * @brief Load the pointer stored in source and protect it with the given hazard pointer.
+     *
+     * Loops until the published pointer is still the one stored in source, i.e. it could not have been
+     * retired before the hazard pointer became visible.
+     */
+    template <typename T>
+    static T* protect(std::atomic<void*>& hazard_pointer, const std::atomic<T*>& source)
+    {
+        T* pointer = source.load(std::memory_order_relaxed);
+        T* temp;
+        do
+        {
+            temp = pointer;
+            if constexpr (AsymmetricFence)
+            {
+                hazard_pointer.store(pointer, std::memory_order_relaxed);
+                asymmetric_thread_fence_light();
+                pointer = source.load(std::memory_order_acquire);
+            }
+            else
+            {
+                hazard_pointer.store(pointer);
+                pointer = source.load();
+            }
+        }
+        while (pointer != temp);
+        return pointer;
+    }
+
+    class Guard
+    {
+        std::atomic<void*>& hazard_pointer;
+
+    public:
+        /**
+         * @param slot Slot of the calling thread's record to use. Guards alive at the same time need different slots.
+         */
+        explicit Guard(std::size_t slot = 0) : hazard_pointer(get_hazard_pointer(slot))
+        {
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        ~Guard()
+        {
+            reset();
+        }
+
+        template <typename T>
+        T* protect(const std::atomic<T*>& source)
+        {
+            return BasicHazardPointerReclamation::protect(hazard_pointer, source);
+        }
+
+        /**
+         * @brief Publish pointer without validating it. The caller has to check afterwards that the node was still
+         * reachable, e.g. that the node it was read from is still linked.
+         */
+        template <typename T>
+        void publish(T* pointer)
+        {
+            if constexpr (AsymmetricFence)
+            {
+                hazard_pointer.store(pointer, std::memory_order_relaxed);
+                asymmetric_thread_fence_light();
+            }
+            else
+            {
+                hazard_pointer.store(pointer);
+            }
+        }
+
+        void reset()
+        {
+            hazard_pointer.store(nullptr, std::memory_order_release);
+        }
+    };
+
+    template <typename Node, typename Deleter = std::default_delete<Node>>
+    using retire_list = RetireList<Node, Deleter, AsymmetricFence>;
+};
+
+/// Hazard pointers with a seq_cst store on every publish.
+using HazardPointerReclamation = BasicHazardPointerReclamation<false>;
+/// Hazard pointers with a compiler-only fence on publish and a membarrier before every scan.
+using AsymmetricHazardPointerReclamation = BasicHazardPointerReclamation<true>;
+
+#endif //HAZARD_POINTER_RECLAMATION_H
@@ -7,63 +7,268 @@
 // Following the implementation from paper: Lock-free parallel dynamic programming.
 // This implementation is for the purpose of solving dynamic programming problems using
 // a parallelized top-down approach
+#include <algorithm>
 #include <atomic>
+#include <cassert>
+#include <span>
+#include <thread>
+#include <utility>
 #include <vector>
-// The hash-table size is allocated once at compile time and it uses a simple modular hash.
+#include "hash_policy.h"
+#include "numa_placement.h"
+// The hash-table size is allocated once at compile time. Keys are spread with the Hasher policy (hash_policy.h);
+// a power-of-two TableSize replaces the modulo of the index computation and of the probing by a mask.
 // This requires that the problem size (number of hash values) must be estimated before.
+// On NUMA machines the table can be initialized by threads on all nodes, see TablePlacement (numa_placement.h).
+// erase() leaves the key in its entry as a tombstone with no_value; only a later insert of the same key reuses it.
+// Churn of distinct keys fills the table with tombstones until compact() rehashes the live entries, which requires
+// that no other thread uses the table meanwhile. ResizableLockFreeHashTable drops tombstones while it stays in use.
+// get_or_compute() memoizes a function: it marks the value of a key as being computed with IN_PROGRESS_VALUE, which
+// has to be reserved for that purpose, so that concurrent callers wait for the result instead of computing it again.
 
-template <typename KeyType, typename ValueType, KeyType NO_KEY, ValueType NO_VALUE, size_t TableSize>
+/// Number of times get_or_compute() rereads a value that is being computed before it starts yielding the thread.
+constexpr unsigned hash_table_compute_wait_spins = 64;
+/// Number of keys lookup_batch() and insert_batch() hash and prefetch before they resolve the first of them.
+constexpr size_t hash_table_prefetch_window = 16;
+
+template <typename KeyType, typename ValueType, KeyType NO_KEY, ValueType NO_VALUE, size_t TableSize,
+          typename Hasher = MixingHash<KeyType>, ValueType IN_PROGRESS_VALUE = NO_VALUE>
 requires std::is_integral_v<KeyType> && std::is_trivially_copyable_v<ValueType>
 class LockFreeHashTable
 {
 public:
+    using key_type = KeyType;
+    using mapped_type = ValueType;
     static constexpr KeyType no_key = NO_KEY;
     static constexpr ValueType no_value = NO_VALUE;
+    static constexpr ValueType in_progress_value = IN_PROGRESS_VALUE;
     struct Entry
     {
         std::atomic<KeyType> key;
         std::atomic<ValueType> value;
     };
 
-    LockFreeHashTable() : table(TableSize)
+    LockFreeHashTable() : LockFreeHashTable(TablePlacement::single_thread)
     {
-        for (size_t i = 0; i < TableSize; i++)
+    }
+
+    /**
+     * @param placement How the entries are spread over the NUMA nodes; they are initialized by the touching threads.
+     * @param num_threads Threads initializing the table, 0 for one per CPU. Ignored for TablePlacement::single_thread.
+     */
+    explicit LockFreeHashTable(TablePlacement placement, size_t num_threads = 0)
+        : table(TableSize, placement, num_threads, [](Entry* entry)
         {
-            table[i].key.store(NO_KEY, std::memory_order_relaxed);
-            table[i].value.store(no_value, std::memory_order_relaxed);
-        }
+            new(entry) Entry;
+            entry->key.store(NO_KEY, std::memory_order_relaxed);
+            entry->value.store(NO_VALUE, std::memory_order_relaxed);
+        })
+    {
     }
 
     bool insert(KeyType key, ValueType value)
+    {
+        Entry* entry = claim(key);
+        if (!entry)
+        {
+            return false;
+        }
+        entry->value.store(value, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Value of key, computed with compute(key) and inserted if key has none yet.
+     *
+     * Exactly one of the threads calling get_or_compute() for the same key runs compute, the others wait for its
+     * result. compute may call get_or_compute() for other keys, as long as the dependencies between keys form no
+     * cycle, as for the subproblems of a dynamic program. If compute throws, the key is released again. If the table
+     * is full, the value is computed without being stored.
+     */
+    template <typename Compute>
+    ValueType get_or_compute(KeyType key, Compute&& compute)
+    {
+        static_assert(IN_PROGRESS_VALUE != NO_VALUE, "get_or_compute() requires a reserved IN_PROGRESS_VALUE");
+        Entry* entry = claim(key);
+        if (!entry)
+        {
+            return compute(key);
+        }
+        ValueType value = entry->value.load(std::memory_order_acquire);
+        for (unsigned waited = 0;; ++waited)
+        {
+            if (value == NO_VALUE)
+            {
+                if (!entry->value.compare_exchange_strong(value, IN_PROGRESS_VALUE, std::memory_order_acq_rel,
+                                                          std::memory_order_acquire))
+                {
+                    continue;
+                }
+                try
+                {
+                    const ValueType result = compute(key);
+                    entry->value.store(result, std::memory_order_release);
+                    return result;
+                }
+                catch (...)
+                {
+                    entry->value.store(NO_VALUE, std::memory_order_release);
+                    throw;
+                }
+            }
+            if (value != IN_PROGRESS_VALUE)
+            {
+                return value;
+            }
+            if (waited >= hash_table_compute_wait_spins)
+            {
+                std::this_thread::yield();
+            }
+            value = entry->value.load(std::memory_order_acquire);
+        }
+    }
+
+    ValueType lookup(KeyType key) const
+    {
+        return lookup_from(key, hash(key));
+    }
+
+    /**
+     * @brief Look up keys[i] into values[i] for all i.
+     *
+     * The keys are processed in windows: the home entries of all keys of a window are prefetched before the first
+     * one is resolved, so the cache misses of independent keys overlap instead of stalling one after the other.
+     */
+    void lookup_batch(std::span<const KeyType> keys, std::span<ValueType> values) const
+    {
+        assert(keys.size() == values.size());
+        size_t home[hash_table_prefetch_window];
+        for (size_t begin = 0; begin < keys.size(); begin += hash_table_prefetch_window)
+        {
+            const size_t count = std::min(hash_table_prefetch_window, keys.size() - begin);
+            for (size_t i = 0; i < count; ++i)
+            {
+                home[i] = hash(keys[begin + i]);
+                prefetch<false>(&table[home[i]]);
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                values[begin + i] = lookup_from(keys[begin + i], home[i]);
+            }
+        }
+    }
+
+    /**
+     * @brief Insert keys[i] with values[i] for all i, prefetching like lookup_batch().
+     * @return Number of keys that were inserted; keys that find the table full are skipped.
+     */
+    size_t insert_batch(std::span<const KeyType> keys, std::span<const ValueType> values)
+    {
+        assert(keys.size() == values.size());
+        size_t home[hash_table_prefetch_window];
+        size_t inserted{};
+        for (size_t begin = 0; begin < keys.size(); begin += hash_table_prefetch_window)
+        {
+            const size_t count = std::min(hash_table_prefetch_window, keys.size() - begin);
+            for (size_t i = 0; i < count; ++i)
+            {
+                home[i] = hash(keys[begin + i]);
+                prefetch<true>(&table[home[i]]);
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (Entry* entry = claim_from(keys[begin + i], home[i]))
+                {
+                    entry->value.store(values[begin + i], std::memory_order_release);
+                    ++inserted;
+                }
+            }
+        }
+        return inserted;
+    }
+
+    /**
+     * @brief Remove the value of key. The entry stays claimed by key until compact().
+     * @return true if key had a value. A value that get_or_compute() is still computing is not removed.
+     */
+    bool erase(KeyType key)
     {
         size_t hash_value = hash(key);
         size_t slots_examined{};
         while (slots_examined < TableSize)
         {
             auto& entry = table[hash_value];
-            KeyType expected = NO_KEY;
-            if (entry.key.load(std::memory_order_acquire) == NO_KEY)
+            auto entry_key = entry.key.load(std::memory_order_acquire);
+            if (entry_key == NO_KEY)
             {
-                if (entry.key.compare_exchange_strong(expected, key, std::memory_order_acq_rel))
-                {
-                    entry.value.store(value, std::memory_order_release);
-                    return true;
-                }
+                return false;
             }
-            else if (entry.key.load(std::memory_order_acquire) == key)
+            if (entry_key == key)
             {
-                entry.value.store(value, std::memory_order_release);
-                return true;
+                // A value that is being computed stays in place, otherwise a waiting get_or_compute() would
+                // compute it a second time
+                auto entry_value = entry.value.load(std::memory_order_acquire);
+                while (entry_value != no_value && entry_value != IN_PROGRESS_VALUE &&
+                    !entry.value.compare_exchange_weak(entry_value, no_value, std::memory_order_acq_rel,
+                                                       std::memory_order_acquire));
+                return entry_value != no_value && entry_value != IN_PROGRESS_VALUE;
             }
             ++slots_examined;
-            hash_value = (hash_value + 1) % TableSize;
+            hash_value = next_probe<TableSize>(hash_value);
         }
         return false;
     }
 
-    ValueType lookup(KeyType key) const
+    /**
+     * @brief Drop all tombstones by reinserting the entries that hold a value into the cleared table.
+     *
+     * Only safe while no other thread accesses the table, e.g. between the phases of a computation: a concurrent
+     * insert may still write the value of an entry whose key has moved.
+     *
+     * @return Number of entries holding a value.
+     */
+    size_t compact()
+    {
+        std::vector<std::pair<KeyType, ValueType>> live;
+        for (size_t index = 0; index < TableSize; ++index)
+        {
+            Entry& entry = table[index];
+            const KeyType key = entry.key.load(std::memory_order_relaxed);
+            const ValueType value = entry.value.load(std::memory_order_relaxed);
+            if (key != NO_KEY && value != NO_VALUE)
+                live.emplace_back(key, value);
+            entry.key.store(NO_KEY, std::memory_order_relaxed);
+            entry.value.store(NO_VALUE, std::memory_order_relaxed);
+        }
+        for (const auto& [key, value] : live)
+            claim(key)->value.store(value, std::memory_order_relaxed);
+        return live.size();
+    }
+
+    /**
+     * @brief Number of entries a lookup of key examines, including the one that ends the probe sequence.
+     */
+    size_t probe_length(KeyType key) const
     {
         size_t hash_value = hash(key);
+        size_t slots_examined{};
+        while (slots_examined < TableSize)
+        {
+            ++slots_examined;
+            auto entry_key = table[hash_value].key.load(std::memory_order_acquire);
+            if (entry_key == NO_KEY || entry_key == key)
+                break;
+            hash_value = next_probe<TableSize>(hash_value);
+        }
+        return slots_examined;
+    }
+
+private:
+    PlacedArray<Entry> table;
+
+    // Probe for key starting at its home entry hash_value.
+    ValueType lookup_from(KeyType key, size_t hash_value) const
+    {
         size_t slots_examined{};
         while (slots_examined < TableSize)
         {
@@ -76,21 +281,57 @@ public:
             if (entry_key == key)
             {
                 auto entry_value = entry.value.load(std::memory_order_acquire);
-                // Is this needed to be thread safe?
-                return (entry_value != no_value) ? entry_value : no_value;
+                return (entry_value != IN_PROGRESS_VALUE) ? entry_value : no_value;
             }
             ++slots_examined;
-            hash_value = (hash_value + 1) % TableSize;
+            hash_value = next_probe<TableSize>(hash_value);
         }
         return no_value;
     }
 
-private:
-    std::vector<Entry> table;
+    // Find the entry of key or claim an empty one for it. Returns nullptr if every entry holds another key.
+    Entry* claim(KeyType key)
+    {
+        return claim_from(key, hash(key));
+    }
+
+    // Same as claim(), starting at the already computed home entry of key.
+    Entry* claim_from(KeyType key, size_t hash_value)
+    {
+        size_t slots_examined{};
+        while (slots_examined < TableSize)
+        {
+            auto& entry = table[hash_value];
+            KeyType entry_key = entry.key.load(std::memory_order_acquire);
+            if (entry_key == NO_KEY &&
+                entry.key.compare_exchange_strong(entry_key, key, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                return &entry;
+            }
+            // Also covers losing the race for an empty entry against the same key
+            if (entry_key == key)
+            {
+                return &entry;
+            }
+            ++slots_examined;
+            hash_value = next_probe<TableSize>(hash_value);
+        }
+        return nullptr;
+    }
 
     static size_t hash(KeyType key)
     {
-        return size_t(std::hash<KeyType>{}(key)) % TableSize;
+        return reduce_hash<TableSize>(size_t(Hasher{}(key)));
+    }
+
+    template <bool ForWrite>
+    static void prefetch(const Entry* entry)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(entry, ForWrite ? 1 : 0, 3);
+#else
+        (void)entry;
+#endif
     }
 };
 
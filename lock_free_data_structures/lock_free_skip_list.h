@@ -7,217 +7,661 @@
 
 #include <atomic>
 #include <random>
+#include <bit>
+#include <algorithm>
+#include <cmath>
 #include <array>
 #include <thread>
 #include <concepts>
-#include <hazard_pointer.h>
-#include <retire_list.h>
+#include <memory>
+#include <new>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <cstdint>
+#include <limits>
+#include <iterator>
+#include <utility>
+#include <hazard_pointer_reclamation.h>
 
-template <typename KeyType, typename ValueType, int MaxLevel>
+// Nodes are allocated with a rebound copy of the stateless Allocator, e.g. PoolAllocator (pool_allocator.h).
+// A node carries forward pointers only up to its own level: the tower of top_level + 1 pointers follows the node in
+// the same allocation. With probability 0.5 half of the nodes are on level 0 and need a single forward pointer.
+//
+// Removal follows the lock-free skip list of Herlihy and Shavit: the lowest bit of a forward pointer marks its node
+// as removed on that level. A remove marks the levels from the top down, the mark on level 0 decides which thread
+// removed the key. Traversals unlink marked nodes they pass. Every traversal protects the predecessor, the current
+// node and its successor with the hazard pointer slots 0 to 2, and moves on from a node only while that node is
+// unmarked, i.e. still linked. A node is retired by whichever of its insert and its remove finishes last, after one
+// more traversal has unlinked it from every level.
+//
+// Ordered access is weakly consistent: range_scan() and the iterators see every key that is present during the whole
+// scan exactly once and in ascending order; keys inserted or removed meanwhile may or may not be seen.
+/// Hazard pointer slot a LockFreeSkipList::Finger keeps its node in between operations; the traversals use 0 to 2.
+constexpr std::size_t skip_list_finger_slot = 4;
+/// Level whose predecessor a finger remembers. From there a search covers about 2^level nodes per step.
+constexpr int skip_list_finger_level = 3;
+/// Steps a search started at a finger may take on the finger's level before it starts over from the head.
+constexpr int skip_list_finger_steps = 8;
+static_assert(skip_list_finger_slot < hazard_pointer_slots);
+/// Whether the calling thread has a LockFreeSkipList::Finger alive; all fingers share skip_list_finger_slot.
+inline thread_local bool skip_list_finger_alive = false;
+
+/**
+ * @brief splitmix64 finalizer, turns consecutive seeds into well distributed generator states.
+ */
+constexpr std::uint64_t splitmix64(std::uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Next number of the calling thread's xorshift64* generator.
+ *
+ * The state is a single thread_local word, so drawing never writes memory shared with other threads. Every thread
+ * seeds its generator once from std::random_device.
+ */
+inline std::uint64_t thread_local_random()
+{
+    // Constant initialized, so accessing it needs no guard; 0 is never reached by xorshift and marks a fresh thread
+    thread_local std::uint64_t state = 0;
+    if (state == 0) [[unlikely]]
+        state = splitmix64(std::random_device{}()) | 1;
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545f4914f6cdd1dULL;
+}
+
+/**
+ * @class SkipListLevels
+ * @brief Draws node levels: level l with probability (1 - p) * p^l, capped at MaxLevel.
+ *
+ * For p = 2^-b the level is the number of trailing zero bits of one random word divided by b, so a level costs one
+ * draw of thread_local_random() and a countr_zero. Other probabilities compare one draw per level with p * 2^64.
+ */
+template <int MaxLevel>
+class SkipListLevels
+{
+    int bits_per_level{};
+    std::uint64_t threshold{};
+
+public:
+    explicit SkipListLevels(float probability)
+    {
+        for (int bits = 1; bits < 64; ++bits)
+        {
+            if (probability == std::ldexp(1.0f, -bits))
+            {
+                bits_per_level = bits;
+                return;
+            }
+        }
+        threshold = probability >= 1.0f ? std::numeric_limits<std::uint64_t>::max()
+                  : probability <= 0.0f ? 0
+                  : static_cast<std::uint64_t>(std::ldexp(static_cast<double>(probability), 64));
+    }
+
+    int operator()() const
+    {
+        std::uint64_t word = thread_local_random();
+        if (bits_per_level)
+            return std::min(MaxLevel, std::countr_zero(word) / bits_per_level);
+        int level{};
+        while (level < MaxLevel && word < threshold)
+        {
+            ++level;
+            word = thread_local_random();
+        }
+        return level;
+    }
+};
+
+template <typename KeyType, typename ValueType, int MaxLevel, typename Reclamation = HazardPointerReclamation,
+          typename Allocator = std::allocator<ValueType>>
     requires std::integral<KeyType>
 class LockFreeSkipList
 {
 private:
-    struct Node
+    struct Node : RetireListHook<Node>
     {
         KeyType key;
         ValueType value;
         int top_level;
-        std::atomic<bool> marked;
-        std::atomic<bool> fully_linked;
-        std::array<std::atomic<Node*>, MaxLevel + 1> forward;
+        /// The steps done with the node, inserted and removed. Both have to be done before it is retired.
+        std::atomic<unsigned char> finished_steps;
 
         Node(const KeyType& k, const ValueType& v, int level)
-            : key(k), value(v), top_level(level), marked(false), fully_linked(false)
+            : key(k), value(v), top_level(level), finished_steps(0)
         {
-            for (int i = 0; i <= MaxLevel; ++i)
+            for (int i = 0; i <= level; ++i)
             {
-                forward[i].store(nullptr, std::memory_order_relaxed);
+                new(tower() + i) std::atomic<Node*>(nullptr);
             }
         }
+
+        // Forward pointer of the given level, which must not exceed top_level
+        std::atomic<Node*>& forward(int level)
+        {
+            return tower()[level];
+        }
+
+        // Bytes of a node of the given level including its tower
+        static constexpr std::size_t size(int level)
+        {
+            return sizeof(Node) + (level + 1) * sizeof(std::atomic<Node*>);
+        }
+
+    private:
+        std::atomic<Node*>* tower()
+        {
+            return std::launder(reinterpret_cast<std::atomic<Node*>*>(reinterpret_cast<std::byte*>(this) + sizeof(Node)));
+        }
+    };
+    static_assert(alignof(Node) >= alignof(std::atomic<Node*>), "the tower has to be aligned behind the node");
+    static_assert(std::is_trivially_destructible_v<std::atomic<Node*>>);
+
+    // Nodes are allocated in units of their alignment, the allocator never sees the Node type itself
+    struct alignas(Node) NodeBlock
+    {
+        std::byte bytes[alignof(Node)];
     };
+    using BlockAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<NodeBlock>;
+    using BlockTraits = std::allocator_traits<BlockAllocator>;
+
+    static constexpr std::size_t block_count(int level)
+    {
+        return (Node::size(level) + sizeof(NodeBlock) - 1) / sizeof(NodeBlock);
+    }
+
+    struct NodeDeleter
+    {
+        void operator()(Node* node) const
+        {
+            BlockAllocator allocator;
+            const std::size_t blocks = block_count(node->top_level);
+            std::destroy_at(node);
+            BlockTraits::deallocate(allocator, reinterpret_cast<NodeBlock*>(node), blocks);
+        }
+    };
+
+    static Node* create_node(const KeyType& key, const ValueType& value, int level)
+    {
+        BlockAllocator allocator;
+        NodeBlock* blocks = BlockTraits::allocate(allocator, block_count(level));
+        try
+        {
+            return ::new(static_cast<void*>(blocks)) Node(key, value, level);
+        }
+        catch (...)
+        {
+            BlockTraits::deallocate(allocator, blocks, block_count(level));
+            throw;
+        }
+    }
+
+    static constexpr unsigned char inserted = 1;
+    static constexpr unsigned char removed = 2;
+
+    static bool is_marked(Node* pointer)
+    {
+        return reinterpret_cast<std::uintptr_t>(pointer) & 1;
+    }
+
+    static Node* marked(Node* pointer)
+    {
+        return reinterpret_cast<Node*>(reinterpret_cast<std::uintptr_t>(pointer) | 1);
+    }
+
+    static Node* unmarked(Node* pointer)
+    {
+        return reinterpret_cast<Node*>(reinterpret_cast<std::uintptr_t>(pointer) & ~std::uintptr_t{1});
+    }
+
+    using Guard = typename Reclamation::Guard;
+
+    // Guards of one traversal. The roles rotate as the traversal moves on, so no node has to be protected twice.
+    struct Traversal
+    {
+        Guard guards[3]{Guard(0), Guard(1), Guard(2)};
+        Guard* predecessor = &guards[0];
+        Guard* current = &guards[1];
+        Guard* successor = &guards[2];
+
+        // The current node becomes the predecessor, the successor the current node
+        void advance()
+        {
+            Guard* free = predecessor;
+            predecessor = current;
+            current = successor;
+            successor = free;
+        }
+
+        // The successor replaces the unlinked current node
+        void skip()
+        {
+            std::swap(current, successor);
+        }
+    };
+
+public:
+    /**
+     * @class Finger
+     * @brief Search hint for keys that arrive almost sorted.
+     *
+     * Remembers the predecessor on level skip_list_finger_level of the last search it was passed to, protected by the
+     * hazard pointer slot skip_list_finger_slot. The next search for a larger key starts there instead of at the
+     * head's top level. The remembered node is validated like any other step: once it is removed the search starts
+     * over from the head. A finger belongs to the thread that created it. As every finger protects its node with the
+     * same slot, a thread can only keep one finger alive at a time, even across lists; constructing a second one
+     * while the first is alive throws std::logic_error.
+     *
+     * With EpochReclamation the finger pins its thread for its whole lifetime, so the global epoch cannot advance and
+     * no thread's retired nodes are freed until it is destroyed. Keep such fingers short-lived, e.g. one per batch of
+     * sorted inserts, and never hold one while the thread blocks.
+     */
+    class Finger
+    {
+    public:
+        Finger() = default;
+        Finger(const Finger&) = delete;
+        Finger& operator=(const Finger&) = delete;
+
+    private:
+        friend class LockFreeSkipList;
+
+        // Constructed before the guard: a second finger must not even create its guard, whose destructor would
+        // clear the hazard pointer of the first one
+        struct Ownership
+        {
+            Ownership()
+            {
+                if (skip_list_finger_alive)
+                    throw std::logic_error("a thread can only keep one LockFreeSkipList::Finger alive at a time");
+                skip_list_finger_alive = true;
+            }
+
+            ~Ownership()
+            {
+                skip_list_finger_alive = false;
+            }
+
+            Ownership(const Ownership&) = delete;
+            Ownership& operator=(const Ownership&) = delete;
+        } ownership;
+        Guard guard{skip_list_finger_slot};
+        Node* node{nullptr};
+        /// The list the node belongs to, a finger passed to another list starts over
+        const LockFreeSkipList* list{nullptr};
+    };
+
+private:
+    // The predecessor of a key on one level and the node after it, which is the first one with a key not smaller
+    struct Window
+    {
+        Node* predecessor;
+        Node* successor;
+    };
+
     Node* head;
     Node* tail;
-    RetireList<Node> retire_list;
+    typename Reclamation::template retire_list<Node, NodeDeleter> retire_list;
     float probability{};
     size_t node_count{};
-    std::mt19937 generator;
-    std::bernoulli_distribution distribution;
-    Node* protect(std::atomic<Node*>& incoming_pointer) {
-        Node* node_pointer;
-        auto& hazard_pointer = get_hazard_pointer();
-        do {
-            node_pointer = incoming_pointer.load(std::memory_order_acquire);
-            hazard_pointer.store(node_pointer, std::memory_order_seq_cst);
-        } while (node_pointer != incoming_pointer.load(std::memory_order_acquire));
-        return node_pointer;
-    }
-    // Randomly generate a level for a new node
+    SkipListLevels<MaxLevel> levels;
+
+    // Randomly generate a level for a new node, from the calling thread's generator
     int randomLevel()
     {
-        int level{};
-        while (level < MaxLevel && distribution(generator))
+        return levels();
+    }
+
+    // Load the successor of the protected node on level and protect it with guard. Returns nullptr if the node is
+    // marked on level: its successor may already be unlinked and retired, so the traversal has to start over.
+    static Node* protect_next(Node* node, int level, Guard& guard)
+    {
+        Node* next = node->forward(level).load(std::memory_order_acquire);
+        while (!is_marked(next))
         {
-            level++;
+            guard.publish(next);
+            // The node was still linked with next after next was published, so next was not retired before
+            Node* validated = node->forward(level).load();
+            if (validated == next)
+                return next;
+            next = validated;
         }
-        return level;
+        return nullptr;
+    }
+
+    // Search the window of key on bottom_level, descending from the top level and unlinking every marked node on the
+    // way. On return the predecessor and the successor are protected by the traversal; the successor was unmarked.
+    //
+    // With a finger of this list the search starts at the finger's node if that is before key, and the finger
+    // remembers the new predecessor on its level. A search that needs a restart, or more than skip_list_finger_steps
+    // steps on the finger's level, starts over from the head.
+    Window find_window(const KeyType& key, int bottom_level, Traversal& traversal, Finger* finger = nullptr)
+    {
+        constexpr int finger_level = std::min(skip_list_finger_level, MaxLevel);
+        if (finger && finger->list != this)
+        {
+            finger->list = this;
+            finger->node = nullptr;
+        }
+        bool use_finger = finger && bottom_level <= finger_level;
+    retry:
+        Node* predecessor = head;
+        Node* current = nullptr;
+        int top_level = MaxLevel;
+        const bool from_finger = use_finger && finger->node && finger->node->key < key;
+        if (from_finger)
+        {
+            predecessor = finger->node;
+            top_level = finger_level;
+        }
+        for (int level = top_level; level >= bottom_level; --level)
+        {
+            current = protect_next(predecessor, level, *traversal.current);
+            if (!current)
+            {
+                use_finger = false;
+                goto retry;
+            }
+            int steps{};
+            while (true)
+            {
+                Node* next = current->forward(level).load(std::memory_order_acquire);
+                if (is_marked(next))
+                {
+                    // Unlink the removed node; its frozen successor stays valid as long as the node is linked
+                    next = unmarked(next);
+                    traversal.successor->publish(next);
+                    Node* expected = current;
+                    if (predecessor->forward(level).load() != current ||
+                        !predecessor->forward(level).compare_exchange_strong(expected, next))
+                    {
+                        use_finger = false;
+                        goto retry;
+                    }
+                    current = next;
+                    traversal.skip();
+                }
+                else if (current->key < key)
+                {
+                    next = protect_next(current, level, *traversal.successor);
+                    if (!next || (from_finger && level == finger_level && ++steps > skip_list_finger_steps))
+                    {
+                        use_finger = false;
+                        goto retry;
+                    }
+                    predecessor = current;
+                    current = next;
+                    traversal.advance();
+                }
+                else
+                {
+                    break;
+                }
+            }
+            if (finger && level == finger_level)
+            {
+                // Still protected by the traversal, or by the finger itself
+                finger->guard.publish(predecessor);
+                finger->node = predecessor;
+            }
+        }
+        return {predecessor, current};
+    }
+
+    // Record that the insert or the remove of node is done. The last of the two unlinks the node from the levels it
+    // may still be linked on and retires it; until then neither can free it.
+    void finish(Node* node, unsigned char step, Traversal& traversal)
+    {
+        if ((node->finished_steps.fetch_or(step, std::memory_order_acq_rel) | step) != (inserted | removed))
+            return;
+        find_window(node->key, 0, traversal);
+        retire_list.retire(node);
     }
 
 public:
     LockFreeSkipList(float probability = 0.5f)
-        : probability(probability), generator(std::random_device{}()), distribution(probability)
+        : probability(probability), levels(probability)
     {
-        head = new Node(std::numeric_limits<KeyType>::lowest(), ValueType{}, MaxLevel);
-        tail = new Node(std::numeric_limits<KeyType>::max(), ValueType{}, MaxLevel);
+        head = create_node(std::numeric_limits<KeyType>::lowest(), ValueType{}, MaxLevel);
+        tail = create_node(std::numeric_limits<KeyType>::max(), ValueType{}, MaxLevel);
         for (int i = 0; i <= MaxLevel; ++i)
         {
-            head->forward[i].store(tail, std::memory_order_relaxed);
+            head->forward(i).store(tail, std::memory_order_relaxed);
         }
     }
 
+    LockFreeSkipList(const LockFreeSkipList&) = delete;
+    LockFreeSkipList& operator=(const LockFreeSkipList&) = delete;
+
+    // No other thread may access the list anymore. Removed nodes are unlinked and owned by the retire lists.
     ~LockFreeSkipList()
     {
-        // TODO: This is most likely wrong ... probably needs hazard pointers or something else ...
         Node* node = head;
         while (node)
         {
-            Node* next = node->forward[0].load();
-            delete node;
+            Node* next = node == tail ? nullptr : unmarked(node->forward(0).load(std::memory_order_relaxed));
+            NodeDeleter{}(node);
             node = next;
         }
     }
 
-    bool find_node(const KeyType& key, std::array<Node*, MaxLevel + 1>& predecessors,
-                   std::array<Node*, MaxLevel + 1>& successors)
+    /**
+     * @param finger Optional search hint of the calling thread, see Finger.
+     */
+    bool insert(const KeyType& key, const ValueType& value, Finger* finger = nullptr)
     {
-        bool found = false;
-        Node* previous = head;
-        for (int level = MaxLevel - 1; level > -1; --level)
+        Traversal traversal;
+        Node* new_node = nullptr;
+        while (true)
+        {
+            auto [predecessor, successor] = find_window(key, 0, traversal, finger);
+            if (successor != tail && successor->key == key)
+            {
+                if (new_node)
+                    NodeDeleter{}(new_node);
+                return false;
+            }
+            if (!new_node)
+                new_node = create_node(key, value, randomLevel());
+            new_node->forward(0).store(successor, std::memory_order_relaxed);
+            if (predecessor->forward(0).compare_exchange_strong(successor, new_node))
+                break;
+        }
+        // link higher levels, unless a remove has started to mark them
+        for (int level = 1; level <= new_node->top_level; ++level)
         {
-            auto current = previous->forward[level].load(std::memory_order_acquire);
             while (true)
             {
-                auto next = current->forward[level].load(std::memory_order_acquire);
-                if (current->marked.load(std::memory_order_relaxed))
-                {
-                    if (!previous->forward[level].compare_exchange_strong(current, next))
-                        return find_node(key, predecessors, successors);
-                    current = next;
-                }
-                else
+                auto [predecessor, successor] = find_window(key, level, traversal);
+                Node* next = new_node->forward(level).load(std::memory_order_acquire);
+                if (is_marked(next) ||
+                    (next != successor && !new_node->forward(level).compare_exchange_strong(next, successor)))
                 {
-                    if (current->key < key)
-                    {
-                        previous = current;
-                        current = next;
-                    }
-                    else
-                        break;
+                    finish(new_node, inserted, traversal);
+                    return true;
                 }
+                if (predecessor->forward(level).compare_exchange_strong(successor, new_node))
+                    break;
             }
-            predecessors[level] = previous;
-            successors[level] = current;
         }
-        auto candidate = successors[0];
-        if (candidate->key == key && candidate->fully_linked.load(std::memory_order_acquire) && !candidate->marked.load(
-            std::memory_order_acquire))
-            found = true;
-        return found;
+        finish(new_node, inserted, traversal);
+        return true;
     }
 
-    bool insert(const KeyType& key, const ValueType& value)
+    bool remove(const KeyType& key, Finger* finger = nullptr)
     {
-        std::array<Node*, MaxLevel + 1> predecessors;
-        std::array<Node*, MaxLevel + 1> successors;
-        while (true)
+        Traversal traversal;
+        Node* node_to_remove = find_window(key, 0, traversal, finger).successor;
+        if (node_to_remove == tail || node_to_remove->key != key)
+            return false;
+        for (int level = node_to_remove->top_level; level > 0; --level)
         {
-            if (find_node(key, predecessors, successors))
-                return false;
-            int new_level = randomLevel();
-            auto new_node = new Node(key, value, new_level);
-            for (int level = 0; level <= new_level; ++level)
+            Node* next = node_to_remove->forward(level).load(std::memory_order_acquire);
+            while (!is_marked(next) && !node_to_remove->forward(level).compare_exchange_weak(next, marked(next)))
             {
-                new_node->forward[level].store(successors[level], std::memory_order_relaxed);
             }
-
-            auto previous = predecessors[0];
-            auto next = successors[0];
-            if (!previous->forward[0].compare_exchange_strong(next, new_node))
-            {
-                delete new_node;
-                continue;
-            }
-            // link higher levels
-            for (int level = 1; level <= new_level; ++level)
-            {
-                while (true)
-                {
-                    previous = predecessors[level];
-                    next = successors[level];
-                    if (predecessors[level]->forward[level].compare_exchange_strong(next, new_node))
-                        break;
-                    find_node(key, predecessors, successors);
-                }
-            }
-            new_node->fully_linked.store(true, std::memory_order_release);
-            return true;
         }
+        // Only one thread can mark level 0
+        Node* next = node_to_remove->forward(0).load(std::memory_order_acquire);
+        do
+        {
+            if (is_marked(next))
+                return false;
+        }
+        while (!node_to_remove->forward(0).compare_exchange_weak(next, marked(next)));
+        finish(node_to_remove, removed, traversal);
+        return true;
     }
 
-    bool remove(const KeyType& key)
+    bool search(const KeyType& key, ValueType& value, Finger* finger = nullptr)
     {
-        std::array<Node*, MaxLevel + 1> predecessors;
-        std::array<Node*, MaxLevel + 1> successors;
-        Node * node_to_remove = nullptr;
-        bool is_marked = false;
-        int top_level{-1};
-        while (true)
+        Traversal traversal;
+        Node* candidate = find_window(key, 0, traversal, finger).successor;
+        if (candidate == tail || candidate->key != key)
+            return false;
+        value = candidate->value;
+        return true;
+    }
+
+    /**
+     * @brief Call callback(key, value) for the keys in [low, high) in ascending order. Returns the number of calls.
+     *
+     * Walks level 0 while the traversal's hazard pointers protect the current node, so callback must not use the list
+     * or anything else protected by the hazard pointer slots 0 to 2.
+     */
+    template <typename Callback>
+    std::size_t range_scan(const KeyType& low, const KeyType& high, Callback&& callback)
+    {
+        Traversal traversal;
+        std::size_t visited{};
+        Node* current = find_window(low, 0, traversal).successor;
+        while (current != tail && current->key < high)
         {
-            if (!find_node(key, predecessors, successors))
-                return false;
-            node_to_remove = successors[0];
-            if (!is_marked)
+            if (is_marked(current->forward(0).load(std::memory_order_acquire)))
             {
-                top_level = node_to_remove->top_level;
-                bool expected = false;
-                if (!node_to_remove->marked.compare_exchange_strong(expected, true))
-                    return false;
-                is_marked = true;
+                // Removed after it was reached, find_window() unlinks it and returns the next present node. The key is
+                // copied, as the traversal stops protecting current.
+                const KeyType key = current->key;
+                current = find_window(key, 0, traversal).successor;
+                continue;
             }
-            // unlink
-            for (int level = top_level; level >= 0; --level)
+            callback(current->key, current->value);
+            ++visited;
+            Node* next = protect_next(current, 0, *traversal.successor);
+            if (!next)
             {
-                Node * next{};
-                do
-                {
-                    next = node_to_remove->forward[level].load(std::memory_order_acquire);
-                }while (!node_to_remove->forward[level].compare_exchange_strong(next, next));
-                predecessors[level]->forward[level].compare_exchange_strong(node_to_remove, next);
+                // Cannot move on from a removed node, continue after its key instead; key < high, so no overflow
+                next = find_window(current->key + 1, 0, traversal).successor;
             }
-            delete node_to_remove;
-            return true;
+            else
+            {
+                traversal.advance();
+            }
+            current = next;
         }
+        return visited;
     }
 
-    bool search(const KeyType& key, ValueType& value)
+    /**
+     * @class Iterator
+     * @brief Weakly consistent forward iterator over the entries in ascending key order.
+     *
+     * An iterator holds a copy of its entry and no hazard pointer, so it stays valid whatever happens to the list;
+     * every increment searches the next larger key, which costs O(log n). Use range_scan() for long scans.
+     */
+    class Iterator
     {
-        auto previous = head;
-        for (int level = MaxLevel ; level > -1; --level)
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<KeyType, ValueType>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        Iterator() = default;
+
+        reference operator*() const
         {
-            auto current = previous->forward[level].load(std::memory_order_acquire);
-            while (current && current->key < key)
-            {
-                previous = current;
-                current = current->forward[level].load(std::memory_order_acquire);
-            }
+            return entry;
+        }
+
+        pointer operator->() const
+        {
+            return &entry;
         }
-        auto current = previous->forward[0].load(std::memory_order_acquire);
-        if(current && current->key == key && current->fully_linked.load(std::memory_order_acquire) && !current->marked.load(std::memory_order_acquire))
+
+        Iterator& operator++()
+        {
+            if (entry.first == std::numeric_limits<KeyType>::max())
+                list = nullptr;
+            else
+                *this = list->lower_bound(entry.first + 1);
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        friend bool operator==(const Iterator& a, const Iterator& b)
+        {
+            if (!a.list || !b.list)
+                return a.list == b.list;
+            return a.list == b.list && a.entry.first == b.entry.first;
+        }
+
+    private:
+        friend class LockFreeSkipList;
+
+        Iterator(LockFreeSkipList* list, const KeyType& key, const ValueType& value) : list(list), entry(key, value)
         {
-            value = current->value;
-            return true;
         }
-        return false;
+
+        /// nullptr for the end iterator
+        LockFreeSkipList* list{nullptr};
+        value_type entry{};
+    };
+
+    /**
+     * @brief Iterator to the first entry whose key is not smaller than key, or end().
+     */
+    Iterator lower_bound(const KeyType& key)
+    {
+        Traversal traversal;
+        Node* node = find_window(key, 0, traversal).successor;
+        if (node == tail)
+            return end();
+        return Iterator(this, node->key, node->value);
+    }
+
+    /**
+     * @brief Iterator to the first entry whose key is greater than key, or end().
+     */
+    Iterator upper_bound(const KeyType& key)
+    {
+        if (key == std::numeric_limits<KeyType>::max())
+            return end();
+        return lower_bound(key + 1);
+    }
+
+    Iterator begin()
+    {
+        return lower_bound(std::numeric_limits<KeyType>::lowest());
+    }
+
+    Iterator end()
+    {
+        return Iterator();
     }
 };
 
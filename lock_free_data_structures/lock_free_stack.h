@@ -5,112 +5,321 @@
 #ifndef LOCK_FREE_STACK_H
 #define LOCK_FREE_STACK_H
 #include <atomic>
+#include <concepts>
+#include <iterator>
+#include <memory>
 #include <thread>
+#include <type_traits>
 #include <optional>
-#include "hazard_pointer.h"
-#include "retire_list.h"
+#include <utility>
+#include <vector>
+#include "cache_line.h"
+#include "elimination_backoff.h"
+#include "hazard_pointer_reclamation.h"
 
 template <typename T>
-struct StackNode
+struct StackNode : RetireListHook<StackNode<T>>
 {
     T data;
     StackNode* next;
 
-    explicit StackNode(T data): data(data), next(nullptr)
+    template <typename... Args>
+    explicit StackNode(Args&&... args): data(std::forward<Args>(args)...), next(nullptr)
     {
     }
 };
 
-template <typename T>
+// The reclamation policy decides how popped nodes are protected and reclaimed:
+// HazardPointerReclamation (hazard_pointer_reclamation.h) or EpochReclamation (epoch_reclamation.h).
+// The backoff policy decides what happens after a failed CAS on head: NoBackoff retries right away,
+// EliminationBackoff lets a colliding push and pop exchange the node directly (elimination_backoff.h).
+// Nodes are allocated with a rebound copy of Allocator, e.g. PoolAllocator (pool_allocator.h). The allocator has to be
+// stateless, since retired nodes are freed by the reclamation policy without access to the stack.
+// Values are moved in and, until the first top() on the stack, moved out; after that pops copy values that are not
+// trivially copyable, so top() never writes shared memory. T may be move-only, then there is no top().
+template <typename T, typename Reclamation = HazardPointerReclamation, typename Backoff = NoBackoff,
+          typename Allocator = std::allocator<T>>
 class LockFreeStack
 {
+    using Guard = typename Reclamation::Guard;
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<StackNode<T>>;
+    using NodeTraits = std::allocator_traits<NodeAllocator>;
+
+    struct NodeDeleter
+    {
+        void operator()(StackNode<T>* node) const
+        {
+            NodeAllocator allocator;
+            NodeTraits::destroy(allocator, node);
+            NodeTraits::deallocate(allocator, node, 1);
+        }
+    };
+
     std::atomic<StackNode<T>*> head;
-    RetireList<StackNode<T>> retireList;
+    typename Reclamation::template retire_list<StackNode<T>, NodeDeleter> retireList;
+    typename Backoff::template elimination_array<StackNode<T>> elimination;
+    // Set by the first top() and never cleared, from then on pops copy values out. It is written once, so top() and
+    // pop() only read it afterwards and its cache line stays shared. Kept away from head, top() only reads head.
+    alignas(cache_line_size) mutable std::atomic<bool> top_used{false};
+
+    template <typename... Args>
+    static StackNode<T>* create_node(Args&&... args)
+    {
+        NodeAllocator allocator;
+        StackNode<T>* node = NodeTraits::allocate(allocator, 1);
+        try
+        {
+            NodeTraits::construct(allocator, node, std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            NodeTraits::deallocate(allocator, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    // Whether the data of nodes that were unlinked before this call can be moved out. A top() that reads such a node
+    // has set top_used and then found the node in head with a seq_cst load, i.e. before the node was unlinked. The
+    // unlinking CAS or exchange on head and this load are seq_cst as well, so the flag is seen here. Moving a
+    // trivially copyable value only reads it, so a concurrent top() does not matter.
+    bool may_move_out() const
+    {
+        if constexpr (!std::copy_constructible<T> || std::is_trivially_copyable_v<T>)
+            return true;
+        else
+            return !top_used.load(std::memory_order_seq_cst);
+    }
+
+    static T take(StackNode<T>* node, bool move_out)
+    {
+        if constexpr (std::copy_constructible<T>)
+        {
+            if (!move_out)
+                return node->data;
+        }
+        return std::move(node->data);
+    }
+
+    void link(StackNode<T>* new_node)
+    {
+        new_node->next = head.load();
+        while (!head.compare_exchange_strong(new_node->next, new_node))
+        {
+            if (elimination.try_push(new_node))
+                return;
+        }
+    }
+
+    // Link the chain first -> ... -> last on top of the stack with a single successful CAS.
+    void splice(StackNode<T>* first, StackNode<T>* last)
+    {
+        last->next = head.load();
+        while (!head.compare_exchange_weak(last->next, first));
+    }
+
+    // Take the data of the detached chain [node, end) into result and retire its nodes,
+    // other threads may still protect them.
+    void drain(StackNode<T>* node, StackNode<T>* end, std::vector<T>& result)
+    {
+        const bool move_out = may_move_out();
+        while (node != end)
+        {
+            StackNode<T>* const next = node->next;
+            result.push_back(take(node, move_out));
+            retireList.retire(node);
+            node = next;
+        }
+    }
 
 public:
     LockFreeStack() = default;
     LockFreeStack(const LockFreeStack&) = delete;
     LockFreeStack& operator=(const LockFreeStack&) = delete;
 
-    void push(T val)
+    // Only safe once no other thread accesses the stack anymore
+    ~LockFreeStack()
     {
-        StackNode<T>* const new_node = new StackNode<T>(val);
-        new_node->next = head.load();
-        while (!head.compare_exchange_strong(new_node->next, new_node));
+        StackNode<T>* node = head.load(std::memory_order_relaxed);
+        while (node)
+        {
+            StackNode<T>* const next = node->next;
+            NodeDeleter{}(node);
+            node = next;
+        }
+    }
+
+    void push(const T& val) requires std::copy_constructible<T>
+    {
+        link(create_node(val));
+    }
+
+    void push(T&& val)
+    {
+        link(create_node(std::move(val)));
+    }
+
+    /**
+     * @brief Construct the value in place from args and push it.
+     */
+    template <typename... Args>
+    void emplace(Args&&... args)
+    {
+        link(create_node(std::forward<Args>(args)...));
     }
 
     std::optional<T> pop()
     {
-        auto& hazard_pointer = get_hazard_pointer();
-        StackNode<T>* old_head = head.load();
-        do
+        Guard guard;
+        StackNode<T>* old_head = guard.protect(head);
+        while (old_head && !head.compare_exchange_strong(old_head, old_head->next))
         {
-            StackNode<T>* temp_node;
-            do
+            // An eliminated node never was part of the stack, nobody else can reference it
+            if (StackNode<T>* node = elimination.try_pop())
             {
-                temp_node = old_head;
-                hazard_pointer.store(old_head);
-                old_head = head.load();
+                std::optional<T> result(std::move(node->data));
+                NodeDeleter{}(node);
+                return result;
             }
-            while (old_head != temp_node);
+            old_head = guard.protect(head);
         }
-        while (old_head && !head.compare_exchange_strong(old_head, old_head->next)) ;
         if (!old_head)
         {
-            hazard_pointer.store(nullptr, std::memory_order_relaxed);
             return std::nullopt;
         }
 
-        hazard_pointer.store(nullptr);
-        T result = old_head->data;
-        if (retireList.is_in_use(old_head))
-            retireList.add_node(old_head);
-        else
-            delete old_head;
-        retireList.delete_unused_nodes();
+        guard.reset();
+        std::optional<T> result(take(old_head, may_move_out()));
+        retireList.retire(old_head);
         return result;
     }
 
-    [[nodiscard]] bool empty() const noexcept
+    /**
+     * @brief Push all values of [first, last) with a single successful CAS on head.
+     *
+     * The chain is built privately, so the values appear at once and in the same order as pushing them one by one,
+     * i.e. the last value ends up on top. If constructing a node throws, nothing is pushed.
+     */
+    template <std::input_iterator Iterator, std::sentinel_for<Iterator> Sentinel>
+    void push_range(Iterator first, Sentinel last)
     {
-        // acquire‐load pairs with pushes/releases to guarantee we see an up-to-date head
-        return head.load(std::memory_order_acquire) == nullptr;
+        if (first == last)
+            return;
+        StackNode<T>* const bottom = create_node(*first);
+        StackNode<T>* top = bottom;
+        try
+        {
+            for (++first; first != last; ++first)
+            {
+                StackNode<T>* const node = create_node(*first);
+                node->next = top;
+                top = node;
+            }
+        }
+        catch (...)
+        {
+            // Nobody else has seen the chain yet
+            while (top)
+            {
+                StackNode<T>* const next = top->next;
+                NodeDeleter{}(top);
+                top = next;
+            }
+            throw;
+        }
+        splice(top, bottom);
     }
 
-    // --- New: lock‐free, hazard‐pointer‐protected top() ---
-    std::optional<T> top() const
+    /**
+     * @brief Detach the whole stack with a single exchange.
+     * @return The values from top to bottom.
+     */
+    std::vector<T> pop_all()
     {
-        auto& hazardPointer = get_hazard_pointer();
-        StackNode<T>* current = head.load(std::memory_order_acquire);
+        std::vector<T> result;
+        drain(head.exchange(nullptr), nullptr, result);
+        return result;
+    }
 
-        // Loop until head is stable under protection
+    /**
+     * @brief Pop up to n values with a single successful CAS on head.
+     *
+     * The first n nodes are walked hand over hand: each node is published before it is read and only trusted if
+     * head still is the protected old head afterwards. As old_head cannot be pushed again while it is protected,
+     * an unchanged head means the chain below it is unchanged as well, so the published node was not retired.
+     *
+     * @return The values from top to bottom.
+     */
+    std::vector<T> pop_n(std::size_t n)
+    {
+        std::vector<T> result;
+        if (n == 0)
+            return result;
+        Guard guard(0);
+        Guard walk_guards[2]{Guard(1), Guard(2)};
         while (true)
         {
-            // Protect the candidate
-            hazardPointer.store(current, std::memory_order_release);
-
-            // Reload head and check it didn't change
-            StackNode<T>* current_updated = head.load(std::memory_order_acquire);
-            if (current_updated == current)
+            StackNode<T>* const old_head = guard.protect(head);
+            if (!old_head)
+                return result;
+            StackNode<T>* last_taken = old_head;
+            bool unchanged = true;
+            for (std::size_t taken = 1; taken < n && last_taken->next; ++taken)
+            {
+                StackNode<T>* const next = last_taken->next;
+                walk_guards[taken % 2].publish(next);
+                if (head.load() != old_head)
+                {
+                    unchanged = false;
+                    break;
+                }
+                last_taken = next;
+            }
+            StackNode<T>* expected = old_head;
+            StackNode<T>* const rest = last_taken->next;
+            if (unchanged && head.compare_exchange_strong(expected, rest))
             {
-                // Either empty (p==nullptr) or stable non-null head
-                break;
+                guard.reset();
+                walk_guards[0].reset();
+                walk_guards[1].reset();
+                drain(old_head, rest, result);
+                return result;
             }
-            // head moved, retry with new pointer
-            current = current_updated;
         }
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        // acquire‐load pairs with pushes/releases to guarantee we see an up-to-date head
+        return head.load(std::memory_order_acquire) == nullptr;
+    }
 
+    // --- New: lock‐free, protected top() ---
+    // Once top() was called, pops of a T that is not trivially copyable copy the value out instead of moving it.
+    std::optional<T> top() const requires std::copy_constructible<T>
+    {
+        if constexpr (!std::is_trivially_copyable_v<T>)
+        {
+            if (!top_used.load(std::memory_order_seq_cst))
+                top_used.store(true, std::memory_order_seq_cst);
+        }
+        Guard guard;
+        // Loop until head is stable under protection
+        StackNode<T>* current = guard.protect(head);
+        if constexpr (!std::is_trivially_copyable_v<T>)
+        {
+            // A seq_cst load after the flag that still finds current in head proves that a pop unlinking current
+            // comes later and sees the flag, see may_move_out(). On x86 this is a plain load.
+            while (current && head.load(std::memory_order_seq_cst) != current)
+                current = guard.protect(head);
+        }
         if (!current)
         {
-            hazardPointer.store(nullptr, std::memory_order_release);
             return std::nullopt;
         }
 
-        // Read data while still protected
+        // Read data while still protected, the guard releases the protection afterward
         T result = current->data;
-
-        // Release our hazard pointer
-        hazardPointer.store(nullptr, std::memory_order_release);
         return result;
     }
 };
@@ -0,0 +1,309 @@
+//
+// Created by andreas on 18.10.26.
+//
+
+#ifndef NUMA_PLACEMENT_H
+#define NUMA_PLACEMENT_H
+// Placement of large arrays on the NUMA nodes of a machine. Linux backs a page with memory of the node of the thread
+// that touches it first, so an array initialized by one thread lives on that thread's node entirely. The helpers here
+// either touch the pages from threads pinned to every node, or bind the pages interleaved with mbind before touching.
+// mbind is called through syscall(), so libnuma is not required.
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @enum TablePlacement
+ * @brief How the pages of a table are distributed over the NUMA nodes.
+ */
+enum class TablePlacement
+{
+    /// The constructing thread touches every page, all of them end up on its node.
+    single_thread,
+    /// Threads pinned to all nodes in turn each initialize one contiguous block of the table.
+    first_touch,
+    /// Pages alternate between the nodes: bound with mbind if the kernel supports it, otherwise touched page by page
+    /// by threads pinned to the nodes in turn.
+    interleave
+};
+
+/// Size of the pages placement works with. Huge pages are placed in the same pattern, just coarser.
+constexpr std::size_t numa_page_size = 4096;
+
+/**
+ * @brief Parse a Linux cpu or node list such as "0-3,8,10-11".
+ */
+inline std::vector<int> parse_numa_list(const std::string& list)
+{
+    std::vector<int> result;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ','))
+    {
+        if (range.empty() || range == "\n")
+            continue;
+        const auto dash = range.find('-');
+        const int first = std::stoi(range.substr(0, dash));
+        const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int value = first; value <= last; ++value)
+            result.push_back(value);
+    }
+    return result;
+}
+
+/**
+ * @brief IDs of the online NUMA nodes in ascending order. They need not be contiguous, e.g. "0,2" if node 1 is
+ * offline. A machine without NUMA information is the single node 0.
+ */
+inline const std::vector<int>& numa_node_ids()
+{
+    static const std::vector<int> ids = []()
+    {
+        std::vector<int> result;
+        std::ifstream online("/sys/devices/system/node/online");
+        std::string list;
+        if (std::getline(online, list))
+            result = parse_numa_list(list);
+        if (result.empty())
+            result.push_back(0);
+        return result;
+    }();
+    return ids;
+}
+
+/**
+ * @brief CPUs of every online NUMA node, one entry per node in the order of numa_node_ids().
+ */
+inline const std::vector<std::vector<int>>& numa_node_cpus()
+{
+    static const std::vector<std::vector<int>> nodes = []()
+    {
+        std::vector<std::vector<int>> result;
+        for (int node : numa_node_ids())
+        {
+            std::ifstream cpus("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            std::string cpu_list;
+            std::getline(cpus, cpu_list);
+            result.push_back(parse_numa_list(cpu_list));
+        }
+        return result;
+    }();
+    return nodes;
+}
+
+inline std::size_t numa_node_count()
+{
+    return numa_node_cpus().size();
+}
+
+/**
+ * @brief Pin the calling thread to the CPUs of node. Returns false if that is not possible.
+ */
+inline bool pin_to_numa_node(std::size_t node)
+{
+#ifdef __linux__
+    const auto& cpus = numa_node_cpus()[node % numa_node_count()];
+    if (cpus.empty())
+        return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+        CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)node;
+    return false;
+#endif
+}
+
+/**
+ * @brief Bind the pages of [address, address + bytes) interleaved to all nodes. Returns false if the kernel refused,
+ * e.g. because it lacks NUMA support or the process may not use some of the nodes.
+ */
+inline bool interleave_pages(void* address, std::size_t bytes)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+    constexpr int mpol_interleave = 3;
+    constexpr std::size_t bits_per_word = 8 * sizeof(unsigned long);
+    const auto& ids = numa_node_ids();
+    if (ids.size() < 2)
+        return false;
+    // The mask is indexed by node ID, which differs from the position in ids once a node is offline
+    const auto max_id = static_cast<std::size_t>(*std::max_element(ids.begin(), ids.end()));
+    std::vector<unsigned long> mask(max_id / bits_per_word + 1, 0);
+    for (int id : ids)
+        mask[std::size_t(id) / bits_per_word] |= 1UL << (std::size_t(id) % bits_per_word);
+    // The kernel reads one bit less than maxnode
+    return syscall(SYS_mbind, address, bytes, mpol_interleave, mask.data(), max_id + 2, 0) == 0;
+#else
+    (void)address;
+    (void)bytes;
+    return false;
+#endif
+}
+
+/**
+ * @class PlacedArray
+ * @brief Fixed-size array whose pages are distributed over the NUMA nodes by a TablePlacement.
+ *
+ * Every element is constructed by the thread that touches its page first. Memory comes from mmap on Linux, so it is
+ * page aligned and untouched until the elements are constructed.
+ */
+template <typename T>
+class PlacedArray
+{
+    // Returns the pages to the system, does not destroy the elements
+    struct ReleasePages
+    {
+        std::size_t bytes;
+
+        void operator()(T* elements) const
+        {
+#ifdef __linux__
+            munmap(elements, bytes);
+#else
+            ::operator delete(elements, std::align_val_t{numa_page_size});
+#endif
+        }
+    };
+
+    std::size_t count;
+    std::size_t bytes;
+    // Owns the pages from the start of the constructor, so they are released if constructing the elements throws
+    std::unique_ptr<T, ReleasePages> elements;
+
+    std::size_t page_count() const
+    {
+        return (bytes + numa_page_size - 1) / numa_page_size;
+    }
+
+    // Construct the elements starting on every stride-th page of [first_page, last_page)
+    template <typename Construct>
+    void construct_pages(std::size_t first_page, std::size_t last_page, std::size_t stride, Construct& construct)
+    {
+        for (std::size_t page = first_page; page < last_page; page += stride)
+        {
+            const std::size_t begin = (page * numa_page_size + sizeof(T) - 1) / sizeof(T);
+            const std::size_t end = std::min(count, ((page + 1) * numa_page_size + sizeof(T) - 1) / sizeof(T));
+            for (std::size_t index = begin; index < end; ++index)
+                construct(elements.get() + index);
+        }
+    }
+
+public:
+    /**
+     * If a thread cannot be started, the calling thread constructs the elements that thread would have, without
+     * pinning itself. If construct throws on the calling thread, the started threads are joined before the exception
+     * propagates; elements constructed so far are not destroyed.
+     *
+     * @param num_threads Threads that touch the pages; 0 uses one per CPU, but at least one per node.
+     * @param construct Called as construct(pointer) to construct every element in place, by the touching thread.
+     */
+    template <typename Construct>
+    PlacedArray(std::size_t count, TablePlacement placement, std::size_t num_threads, Construct construct)
+        : count(count), bytes(std::max<std::size_t>(count * sizeof(T), 1)), elements(nullptr, ReleasePages{bytes})
+    {
+        static_assert(alignof(T) <= numa_page_size);
+#ifdef __linux__
+        void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+            throw std::bad_alloc();
+#else
+        void* memory = ::operator new(bytes, std::align_val_t{numa_page_size});
+#endif
+        elements.reset(static_cast<T*>(memory));
+        const std::size_t pages = page_count();
+        if (placement == TablePlacement::single_thread)
+        {
+            construct_pages(0, pages, 1, construct);
+            return;
+        }
+        if (num_threads == 0)
+            num_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), numa_node_count());
+        num_threads = std::clamp<std::size_t>(num_threads, 1, pages);
+        // Without mbind, interleaving falls back to striping the pages over threads on consecutive nodes. Otherwise
+        // every thread takes one block; once the pages are bound, the kernel interleaves them whoever touches them.
+        const bool striped = placement == TablePlacement::interleave && !interleave_pages(memory, bytes);
+        const std::size_t pages_per_thread = (pages + num_threads - 1) / num_threads;
+        auto touch = [&](std::size_t thread)
+        {
+            if (striped)
+                construct_pages(thread, pages, num_threads, construct);
+            else
+                construct_pages(thread * pages_per_thread, std::min(pages, (thread + 1) * pages_per_thread), 1,
+                                construct);
+        };
+        std::vector<std::thread> threads;
+        threads.reserve(num_threads);
+        try
+        {
+            for (std::size_t thread = 0; thread < num_threads; ++thread)
+            {
+                try
+                {
+                    threads.emplace_back([&, thread]()
+                    {
+                        pin_to_numa_node(thread);
+                        touch(thread);
+                    });
+                }
+                catch (const std::system_error&)
+                {
+                    // Out of threads: touch the remaining share here, on whatever node the calling thread runs
+                    for (; thread < num_threads; ++thread)
+                        touch(thread);
+                    break;
+                }
+            }
+        }
+        catch (...)
+        {
+            // A joinable std::thread would terminate the program when the vector is destroyed
+            for (auto& thread : threads)
+                thread.join();
+            throw;
+        }
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    PlacedArray(const PlacedArray&) = delete;
+    PlacedArray& operator=(const PlacedArray&) = delete;
+
+    ~PlacedArray()
+    {
+        std::destroy_n(elements.get(), count);
+    }
+
+    T& operator[](std::size_t index)
+    {
+        return elements.get()[index];
+    }
+
+    const T& operator[](std::size_t index) const
+    {
+        return elements.get()[index];
+    }
+
+    std::size_t size() const
+    {
+        return count;
+    }
+};
+
+#endif //NUMA_PLACEMENT_H
@@ -0,0 +1,139 @@
+//
+// Created by andreas on 18.10.26.
+//
+
+#ifndef PACKED_LOCK_FREE_HASH_TABLE_H
+#define PACKED_LOCK_FREE_HASH_TABLE_H
+// Variant of LockFreeHashTable for small keys and values: key and value of an entry share one 64-bit atomic word.
+// A key is claimed together with its value by a single CAS, so a reader can never observe a claimed key without
+// its value, and a probe loads one word instead of two atomics.
+// 128-bit words for 64-bit keys and values are not offered: GCC implements std::atomic of 16 bytes with a lock.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "hash_policy.h"
+
+template <typename KeyType, typename ValueType, KeyType NO_KEY, ValueType NO_VALUE, size_t TableSize,
+          typename Hasher = MixingHash<KeyType>>
+requires std::is_integral_v<KeyType> && std::is_trivially_copyable_v<ValueType> &&
+    (sizeof(KeyType) + sizeof(ValueType) <= sizeof(std::uint64_t))
+class PackedLockFreeHashTable
+{
+public:
+    static constexpr KeyType no_key = NO_KEY;
+    static constexpr ValueType no_value = NO_VALUE;
+
+    PackedLockFreeHashTable() : table(TableSize)
+    {
+        for (auto& entry : table)
+        {
+            entry.store(empty_entry, std::memory_order_relaxed);
+        }
+    }
+
+    bool insert(KeyType key, ValueType value)
+    {
+        const std::uint64_t new_entry = pack(key, value);
+        size_t hash_value = hash(key);
+        size_t slots_examined{};
+        while (slots_examined < TableSize)
+        {
+            auto& entry = table[hash_value];
+            std::uint64_t current = entry.load(std::memory_order_acquire);
+            // A failed CAS reloads current, the entry is examined again in case it was claimed for the same key
+            while (current == empty_entry || key_of(current) == key)
+            {
+                if (entry.compare_exchange_weak(current, new_entry, std::memory_order_acq_rel,
+                                                std::memory_order_acquire))
+                {
+                    return true;
+                }
+            }
+            ++slots_examined;
+            hash_value = next_probe<TableSize>(hash_value);
+        }
+        return false;
+    }
+
+    ValueType lookup(KeyType key) const
+    {
+        size_t hash_value = hash(key);
+        size_t slots_examined{};
+        while (slots_examined < TableSize)
+        {
+            const std::uint64_t current = table[hash_value].load(std::memory_order_acquire);
+            if (current == empty_entry)
+            {
+                return no_value;
+            }
+            if (key_of(current) == key)
+            {
+                return value_of(current);
+            }
+            ++slots_examined;
+            hash_value = next_probe<TableSize>(hash_value);
+        }
+        return no_value;
+    }
+
+    /**
+     * @brief Number of entries a lookup of key examines, including the one that ends the probe sequence.
+     */
+    size_t probe_length(KeyType key) const
+    {
+        size_t hash_value = hash(key);
+        size_t slots_examined{};
+        while (slots_examined < TableSize)
+        {
+            ++slots_examined;
+            const std::uint64_t current = table[hash_value].load(std::memory_order_acquire);
+            if (current == empty_entry || key_of(current) == key)
+                break;
+            hash_value = next_probe<TableSize>(hash_value);
+        }
+        return slots_examined;
+    }
+
+private:
+    // The key occupies the first bytes of the word, the value the bytes right after it; unused bytes stay zero.
+    // std::bit_cast instead of memcpy keeps this a constant expression, so empty_entry needs no dynamic initializer.
+    static constexpr std::uint64_t pack(KeyType key, ValueType value)
+    {
+        const auto key_bytes = std::bit_cast<std::array<unsigned char, sizeof(KeyType)>>(key);
+        const auto value_bytes = std::bit_cast<std::array<unsigned char, sizeof(ValueType)>>(value);
+        std::array<unsigned char, sizeof(std::uint64_t)> bytes{};
+        std::copy(key_bytes.begin(), key_bytes.end(), bytes.begin());
+        std::copy(value_bytes.begin(), value_bytes.end(), bytes.begin() + sizeof(KeyType));
+        return std::bit_cast<std::uint64_t>(bytes);
+    }
+
+    static KeyType key_of(std::uint64_t word)
+    {
+        KeyType key;
+        std::memcpy(&key, &word, sizeof(KeyType));
+        return key;
+    }
+
+    static ValueType value_of(std::uint64_t word)
+    {
+        ValueType value;
+        std::memcpy(&value, reinterpret_cast<const unsigned char*>(&word) + sizeof(KeyType), sizeof(ValueType));
+        return value;
+    }
+
+    static constexpr std::uint64_t empty_entry = pack(NO_KEY, NO_VALUE);
+
+    std::vector<std::atomic<std::uint64_t>> table;
+
+    static size_t hash(KeyType key)
+    {
+        return reduce_hash<TableSize>(size_t(Hasher{}(key)));
+    }
+};
+
+#endif //PACKED_LOCK_FREE_HASH_TABLE_H
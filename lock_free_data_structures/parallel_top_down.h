@@ -0,0 +1,108 @@
+//
+// Created by andreas on 18.10.26.
+//
+
+#ifndef PARALLEL_TOP_DOWN_H
+#define PARALLEL_TOP_DOWN_H
+// Parallel top-down dynamic programming on a shared memo table (see LockFreeHashTable::get_or_compute()).
+// A solver computes the value of a subproblem from the values of its subproblems, which it requests through the
+// TopDownContext. Subproblems it will need later can be offered to idle threads with spawn(): the calling thread goes on
+// with the others and finds the spawned ones computed, or being computed, once it gets there.
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include "tagged_lock_free_stack.h"
+
+/**
+ * @class TopDownContext
+ * @brief Handle through which a solver evaluates subproblems and offers them to other threads.
+ *
+ * @tparam Table Memo table providing get_or_compute(), e.g. a LockFreeHashTable with an in-progress value.
+ * @tparam Solver Function object called as solver(key, context) that returns the value of key.
+ */
+template <typename Table, typename Solver>
+class TopDownContext
+{
+public:
+    using KeyType = typename Table::key_type;
+    using ValueType = typename Table::mapped_type;
+
+    TopDownContext(Table& table, const Solver& solver) : table(table), solver(solver)
+    {
+    }
+
+    /**
+     * @brief Value of the subproblem key, computed by the calling thread unless another thread has it already.
+     */
+    ValueType operator()(KeyType key)
+    {
+        return table.get_or_compute(key, [this](KeyType subproblem) { return solver(subproblem, *this); });
+    }
+
+    /**
+     * @brief Offer the subproblem key to idle threads. Only pushed if a thread is idle, otherwise a no-op.
+     */
+    void spawn(KeyType key)
+    {
+        if (idle_threads.load(std::memory_order_relaxed) > 0)
+            spawned.push(key);
+    }
+
+    /**
+     * @brief Solve root with num_threads threads, including the calling one.
+     *
+     * The calling thread starts the recursion at root, the others take spawned subproblems until root is solved.
+     * A thread only ever waits for a subproblem of the one it is computing, or for a spawned subproblem while it
+     * computes nothing, so no two threads can wait for each other.
+     */
+    ValueType solve(KeyType root, std::size_t num_threads)
+    {
+        std::atomic<bool> solved{false};
+        std::vector<std::thread> helpers;
+        for (std::size_t thread = 1; thread < num_threads; ++thread)
+        {
+            helpers.emplace_back([this, &solved]()
+            {
+                idle_threads.fetch_add(1, std::memory_order_relaxed);
+                while (!solved.load(std::memory_order_acquire))
+                {
+                    if (auto key = spawned.pop())
+                    {
+                        idle_threads.fetch_sub(1, std::memory_order_relaxed);
+                        (*this)(*key);
+                        idle_threads.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    else
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        const ValueType result = (*this)(root);
+        solved.store(true, std::memory_order_release);
+        for (auto& helper : helpers)
+            helper.join();
+        return result;
+    }
+
+private:
+    Table& table;
+    const Solver& solver;
+    TaggedLockFreeStack<KeyType> spawned;
+    std::atomic<std::size_t> idle_threads{0};
+};
+
+/**
+ * @brief Solve the dynamic program rooted at root top-down with num_threads threads sharing table.
+ */
+template <typename Table, typename Solver>
+typename Table::mapped_type parallel_top_down(Table& table, typename Table::key_type root, const Solver& solver,
+                                              std::size_t num_threads)
+{
+    TopDownContext<Table, Solver> context(table, solver);
+    return context.solve(root, num_threads);
+}
+
+#endif //PARALLEL_TOP_DOWN_H
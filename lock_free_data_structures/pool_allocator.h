@@ -0,0 +1,259 @@
+//
+// Created by andreas on 18.10.26.
+//
+
+#ifndef POOL_ALLOCATOR_H
+#define POOL_ALLOCATOR_H
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <new>
+#include "cache_line.h"
+
+/// Smallest size class of the pool, in bytes. Size classes are the powers of two from here up to pool_max_block_size.
+constexpr std::size_t pool_min_block_size = 16;
+/// Largest size class of the pool. Bigger requests bypass the pool and go to operator new.
+constexpr std::size_t pool_max_block_size = 4096;
+constexpr std::size_t pool_size_classes = std::countr_zero(pool_max_block_size / pool_min_block_size) + 1;
+/// Size of the chunks a thread cache carves into blocks when its free list of a size class runs empty.
+constexpr std::size_t pool_chunk_size = 64 * 1024;
+
+class PoolThreadCache;
+
+/**
+ * @struct PoolBlockHeader
+ * @brief Precedes every block handed out by the pool; tells deallocate() where the block has to go.
+ */
+struct alignas(16) PoolBlockHeader
+{
+    /// Cache the block was carved for, nullptr for blocks that bypassed the pool.
+    PoolThreadCache* owner;
+    std::size_t size_class;
+};
+
+/**
+ * @struct PoolFreeBlock
+ * @brief A free block reuses its payload as link of a free list.
+ */
+struct PoolFreeBlock
+{
+    PoolFreeBlock* next;
+};
+
+/**
+ * @class PoolThreadCache
+ * @brief Free lists of one thread, one per size class.
+ *
+ * The owning thread allocates from and frees to its local lists without any synchronization. A block freed by
+ * another thread is pushed onto the lock-free remote list of its size class; the owner takes over the whole remote
+ * list with one exchange once its local list is empty. Caches are never destroyed: a cache released by an exiting
+ * thread keeps its blocks and is adopted by the next thread that registers, so a block can always find its way back.
+ */
+class alignas(cache_line_size) PoolThreadCache
+{
+    struct alignas(cache_line_size) RemoteList
+    {
+        std::atomic<PoolFreeBlock*> head{nullptr};
+    };
+
+    PoolFreeBlock* local[pool_size_classes]{};
+    /// Chunks carved by this cache, linked through their first bytes.
+    void* chunks{nullptr};
+    RemoteList remote[pool_size_classes];
+
+    static constexpr std::size_t block_size(std::size_t size_class)
+    {
+        return sizeof(PoolBlockHeader) + (pool_min_block_size << size_class);
+    }
+
+    void refill(std::size_t size_class)
+    {
+        constexpr std::size_t chunk_header = sizeof(PoolBlockHeader);
+        auto* chunk = static_cast<std::byte*>(::operator new(pool_chunk_size));
+        *reinterpret_cast<void**>(chunk) = chunks;
+        chunks = chunk;
+        const std::size_t size = block_size(size_class);
+        for (std::size_t offset = chunk_header; offset + size <= pool_chunk_size; offset += size)
+        {
+            auto* header = new(chunk + offset) PoolBlockHeader{this, size_class};
+            auto* block = new(header + 1) PoolFreeBlock{local[size_class]};
+            local[size_class] = block;
+        }
+    }
+
+public:
+    std::atomic<bool> in_use{false};
+    PoolThreadCache* next{nullptr};
+
+    void* allocate(std::size_t size_class)
+    {
+        PoolFreeBlock* block = local[size_class];
+        if (!block)
+        {
+            block = remote[size_class].head.exchange(nullptr, std::memory_order_acquire);
+            if (!block)
+            {
+                refill(size_class);
+                block = local[size_class];
+            }
+        }
+        local[size_class] = block->next;
+        return block;
+    }
+
+    /// Free a block of this cache from its owning thread.
+    void deallocate_local(void* pointer, std::size_t size_class)
+    {
+        local[size_class] = new(pointer) PoolFreeBlock{local[size_class]};
+    }
+
+    /// Free a block of this cache from any other thread.
+    void deallocate_remote(void* pointer, std::size_t size_class)
+    {
+        auto& head = remote[size_class].head;
+        auto* block = new(pointer) PoolFreeBlock{head.load(std::memory_order_relaxed)};
+        while (!head.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed));
+    }
+};
+
+/**
+ * @class PoolRegistry
+ * @brief All thread caches ever created. Threads claim a released cache before they create a new one.
+ */
+class PoolRegistry
+{
+    std::atomic<PoolThreadCache*> caches{nullptr};
+
+public:
+    PoolThreadCache* acquire_cache()
+    {
+        for (PoolThreadCache* cache = caches.load(std::memory_order_acquire); cache; cache = cache->next)
+        {
+            if (bool expected = false; !cache->in_use.load(std::memory_order_relaxed) &&
+                cache->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                return cache;
+        }
+        auto* cache = new PoolThreadCache;
+        cache->in_use.store(true, std::memory_order_relaxed);
+        cache->next = caches.load(std::memory_order_relaxed);
+        while (!caches.compare_exchange_weak(cache->next, cache, std::memory_order_release,
+                                             std::memory_order_relaxed));
+        return cache;
+    }
+
+    void release_cache(PoolThreadCache* cache)
+    {
+        cache->in_use.store(false, std::memory_order_release);
+    }
+};
+
+/// The registry shared by all pool allocators. Its caches and chunks live until the process exits.
+inline PoolRegistry pool_registry;
+
+/// The calling thread's cache, nullptr before the first allocation and after the thread released it.
+inline thread_local PoolThreadCache* current_pool_cache = nullptr;
+inline thread_local bool pool_cache_released = false;
+
+/**
+ * @brief Get the calling thread's cache, or nullptr if the thread is already exiting and released it.
+ */
+inline PoolThreadCache* get_pool_cache()
+{
+    struct CacheOwner
+    {
+        PoolThreadCache* cache = pool_registry.acquire_cache();
+
+        CacheOwner()
+        {
+            current_pool_cache = cache;
+        }
+
+        ~CacheOwner()
+        {
+            current_pool_cache = nullptr;
+            pool_cache_released = true;
+            pool_registry.release_cache(cache);
+        }
+    };
+
+    if (current_pool_cache || pool_cache_released)
+        return current_pool_cache;
+    thread_local CacheOwner owner;
+    return owner.cache;
+}
+
+/**
+ * @brief Allocate size bytes from the calling thread's cache.
+ */
+inline void* pool_allocate(std::size_t size)
+{
+    const std::size_t size_class = size <= pool_min_block_size
+                                       ? 0
+                                       : std::bit_width((size - 1) / pool_min_block_size);
+    PoolThreadCache* cache = size_class < pool_size_classes ? get_pool_cache() : nullptr;
+    if (!cache)
+    {
+        auto* header = static_cast<PoolBlockHeader*>(::operator new(sizeof(PoolBlockHeader) + size));
+        *header = {nullptr, 0};
+        return header + 1;
+    }
+    return cache->allocate(size_class);
+}
+
+/**
+ * @brief Return a block of pool_allocate() to the cache it was carved for.
+ */
+inline void pool_deallocate(void* pointer)
+{
+    auto* header = static_cast<PoolBlockHeader*>(pointer) - 1;
+    if (!header->owner)
+    {
+        ::operator delete(header);
+        return;
+    }
+    if (header->owner == current_pool_cache)
+        header->owner->deallocate_local(pointer, header->size_class);
+    else
+        header->owner->deallocate_remote(pointer, header->size_class);
+}
+
+/**
+ * @class PoolAllocator
+ * @brief Stateless allocator on top of the per-thread, size-class pools.
+ *
+ * Steady-state allocations and deallocations by the same thread are a pop and a push on a thread-local free list.
+ * Nodes freed by another thread (e.g. a popped stack node reclaimed by the popper) are returned to the allocating
+ * thread's cache with one CAS. Memory is recycled within the pool but never returned to the operating system.
+ */
+template <typename T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+    static_assert(alignof(T) <= alignof(PoolBlockHeader), "over-aligned types are not supported by the pool");
+
+    PoolAllocator() noexcept = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(pool_allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, std::size_t)
+    {
+        pool_deallocate(pointer);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept
+    {
+        return true;
+    }
+};
+
+#endif //POOL_ALLOCATOR_H
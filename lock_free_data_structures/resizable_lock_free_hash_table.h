@@ -0,0 +1,408 @@
+//
+// Created by andreas on 18.10.26.
+//
+
+#ifndef RESIZABLE_LOCK_FREE_HASH_TABLE_H
+#define RESIZABLE_LOCK_FREE_HASH_TABLE_H
+// Growable variant of LockFreeHashTable. Instead of fixing the table size at compile time, a table twice as large is
+// allocated once the load factor threshold is reached. The entries are then migrated in small chunks by every thread
+// that passes through insert() or lookup(), so no single caller pays for the whole resize.
+// Erased keys stay in their entries as tombstones until the next migration, which only copies entries holding a value.
+// If few claimed entries still hold a value, the successor keeps the capacity, so the migration compacts the table.
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include "cache_line.h"
+#include "epoch_reclamation.h"
+#include "hash_policy.h"
+
+/// Number of entries a thread migrates each time it passes through the table.
+constexpr std::size_t hash_table_migration_chunk = 64;
+/// A table is grown once more than numerator / denominator of its entries hold a key.
+constexpr std::size_t hash_table_max_load_numerator = 3;
+constexpr std::size_t hash_table_max_load_denominator = 4;
+
+/**
+ * @class ResizableLockFreeHashTable
+ * @brief Open addressing hash table that grows with incremental, cooperative migration; see below for the cases in
+ * which it is not lock-free.
+ *
+ * While a table is migrated into its successor, an entry is copied by exactly one thread: chunks of entries are
+ * handed out with a fetch_add on a cursor. The migrating thread copies the value into the new table first and only
+ * then freezes the old entry by replacing its value with MOVED_VALUE. If the value changed in between, the copy is
+ * repeated. A writer that finds MOVED_VALUE retries in the new table, and a reader follows it there, where the value
+ * is guaranteed to be present already. Once all chunks are migrated the new table becomes current and the old one is
+ * retired through epoch-based reclamation, which every operation is pinned to.
+ *
+ * erase() replaces the value by NO_VALUE. The key keeps its entry, a later insert of the same key reuses it. Because a
+ * migration skips such tombstones, a resize triggered by churn of distinct keys allocates a table of the same capacity
+ * if at most a quarter of the entries hold a value; compact() starts such a migration explicitly, e.g. from a
+ * maintenance thread. Readers keep running throughout.
+ *
+ * While the successor is filled, every entry of the old table that is not migrated yet may still need an entry in it.
+ * A writer that claims a new key in the successor therefore reserves its entry first: the reservation only succeeds
+ * if the claimed and reserved entries plus the entries left to migrate fit into the successor. Otherwise the writer
+ * helps migrating until it does, so the migration itself can never run out of entries. Writers that find room do not
+ * wait for the migration; a writer that finds the current table completely full while it is still being filled has
+ * to help finishing the previous migration before the table can grow again.
+ *
+ * Progress: lookup(), erase() and inserts of keys that have an entry already never wait, and neither does an insert
+ * that finds room. Such an operation is lock-free. An insert that has to wait for the migration as described above,
+ * and compact(), are not: they help with the chunks that are still unclaimed, but a chunk belongs to the thread that
+ * took it from the cursor. If that thread is preempted in the middle of its chunk, they spin until it resumes. A chunk
+ * cannot be taken over, because values have no spare bit to freeze an entry without losing its value. A helper that
+ * copied an old value could then still overwrite a newer one in the successor after the entry was frozen.
+ *
+ * @tparam MOVED_VALUE Reserved value marking a migrated entry; it must differ from NO_VALUE and is never stored.
+ * @tparam Hasher Hash policy, see hash_policy.h. Capacities are powers of two, so the hash is masked.
+ */
+template <typename KeyType, typename ValueType, KeyType NO_KEY, ValueType NO_VALUE, ValueType MOVED_VALUE,
+          typename Hasher = MixingHash<KeyType>>
+    requires std::is_integral_v<KeyType> && std::is_trivially_copyable_v<ValueType>
+class ResizableLockFreeHashTable
+{
+public:
+    static constexpr KeyType no_key = NO_KEY;
+    static constexpr ValueType no_value = NO_VALUE;
+    static constexpr ValueType moved_value = MOVED_VALUE;
+    static_assert(NO_VALUE != MOVED_VALUE, "the moved marker has to differ from the empty value");
+
+    struct Entry
+    {
+        std::atomic<KeyType> key{NO_KEY};
+        std::atomic<ValueType> value{NO_VALUE};
+    };
+
+    // The initial capacity is rounded up to a power of two
+    explicit ResizableLockFreeHashTable(std::size_t initial_capacity = 1024)
+        : current(new Table(std::bit_ceil(std::max<std::size_t>(initial_capacity, 1))))
+    {
+    }
+
+    ResizableLockFreeHashTable(const ResizableLockFreeHashTable&) = delete;
+    ResizableLockFreeHashTable& operator=(const ResizableLockFreeHashTable&) = delete;
+
+    // Only safe once no other thread accesses the table anymore
+    ~ResizableLockFreeHashTable()
+    {
+        Table* table = current.load();
+        delete table->next.load();
+        delete table;
+    }
+
+    bool insert(KeyType key, ValueType value)
+    {
+        assert(value != NO_VALUE && value != MOVED_VALUE);
+        EpochReclamation::Guard guard;
+        Table* table = guard.protect(current);
+        help_migrate(table);
+        while (true)
+        {
+            Entry* entry = claim_for_insert(table, key);
+            if (!entry)
+            {
+                // Every slot holds another key, so key can only go into the successor
+                table = grow(table);
+                continue;
+            }
+            ValueType entry_value = entry->value.load(std::memory_order_acquire);
+            while (entry_value != MOVED_VALUE &&
+                !entry->value.compare_exchange_weak(entry_value, value, std::memory_order_acq_rel,
+                                                    std::memory_order_acquire));
+            if (entry_value != MOVED_VALUE)
+            {
+                if (entry_value == NO_VALUE)
+                    table->live.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            table = table->next.load(std::memory_order_acquire);
+        }
+    }
+
+    /**
+     * @brief Remove the value of key, leaving a tombstone that the next migration drops.
+     * @return true if key had a value.
+     */
+    bool erase(KeyType key)
+    {
+        EpochReclamation::Guard guard;
+        Table* table = guard.protect(current);
+        help_migrate(table);
+        while (table)
+        {
+            if (Entry* entry = find(table, key))
+            {
+                ValueType entry_value = entry->value.load(std::memory_order_acquire);
+                while (entry_value != NO_VALUE && entry_value != MOVED_VALUE &&
+                    !entry->value.compare_exchange_weak(entry_value, NO_VALUE, std::memory_order_acq_rel,
+                                                        std::memory_order_acquire));
+                if (entry_value != MOVED_VALUE)
+                {
+                    if (entry_value == NO_VALUE)
+                        return false;
+                    table->live.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            table = table->next.load(std::memory_order_acquire);
+        }
+        return false;
+    }
+
+    ValueType lookup(KeyType key) const
+    {
+        EpochReclamation::Guard guard;
+        Table* table = guard.protect(current);
+        help_migrate(table);
+        while (table)
+        {
+            if (const Entry* entry = find(table, key))
+            {
+                const ValueType entry_value = entry->value.load(std::memory_order_acquire);
+                if (entry_value != MOVED_VALUE)
+                    return entry_value;
+            }
+            // Either migrated or never inserted here; a successor may hold the key in both cases
+            table = table->next.load(std::memory_order_acquire);
+        }
+        return no_value;
+    }
+
+    /**
+     * @brief Migrate the current table into a new one, dropping all tombstones.
+     *
+     * The new table has the same capacity unless more than a quarter of the entries hold a value, then it grows.
+     * Returns once the new table is current. If a resize is already under way, it is finished instead.
+     */
+    void compact()
+    {
+        EpochReclamation::Guard guard;
+        Table* table = guard.protect(current);
+        start_resize(table, table->successor_capacity());
+        while (current.load(std::memory_order_acquire) == table)
+        {
+            // The remaining chunks may be handed out to other threads already
+            help_migrate(table);
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * @brief Number of entries of the current table.
+     */
+    std::size_t capacity() const
+    {
+        EpochReclamation::Guard guard;
+        return guard.protect(current)->capacity;
+    }
+
+private:
+    struct Table
+    {
+        const std::size_t capacity;
+        std::unique_ptr<Entry[]> entries;
+        /// Number of claimed or reserved keys, and number of entries holding a value, i.e. claimed keys minus
+        /// tombstones.
+        alignas(cache_line_size) std::atomic<std::size_t> size{0};
+        /// Signed, an erase may be counted before the insert it undoes.
+        std::atomic<std::ptrdiff_t> live{0};
+        /// Next chunk to migrate and number of migrated entries.
+        alignas(cache_line_size) std::atomic<std::size_t> migration_cursor{0};
+        std::atomic<std::size_t> migrated{0};
+        std::atomic<Table*> next{nullptr};
+
+        explicit Table(std::size_t capacity) : capacity(capacity), entries(new Entry[capacity])
+        {
+        }
+
+        std::size_t hash(KeyType key) const
+        {
+            return std::size_t(Hasher{}(key)) & (capacity - 1);
+        }
+
+        std::size_t next_probe(std::size_t index) const
+        {
+            return (index + 1) & (capacity - 1);
+        }
+
+        bool over_threshold(std::size_t claimed) const
+        {
+            return claimed * hash_table_max_load_denominator > capacity * hash_table_max_load_numerator;
+        }
+
+        // Compact into a table of the same capacity only if the live entries plus a quarter of the capacity for
+        // inserts racing the migration leave it at most half full, grow otherwise
+        std::size_t successor_capacity() const
+        {
+            const std::ptrdiff_t headroom = std::ptrdiff_t(capacity / 4);
+            return (live.load(std::memory_order_relaxed) + headroom) * 2 <= std::ptrdiff_t(capacity) ? capacity
+                                                                                                    : capacity * 2;
+        }
+    };
+
+    mutable std::atomic<Table*> current;
+    mutable EpochReclamation::retire_list<Table> retired_tables;
+
+    static Entry* find(const Table* table, KeyType key)
+    {
+        std::size_t index = table->hash(key);
+        for (std::size_t examined = 0; examined < table->capacity; ++examined)
+        {
+            Entry& entry = table->entries[index];
+            const KeyType entry_key = entry.key.load(std::memory_order_acquire);
+            if (entry_key == key)
+                return &entry;
+            if (entry_key == NO_KEY)
+                return nullptr;
+            index = table->next_probe(index);
+        }
+        return nullptr;
+    }
+
+    // Find the entry of key or claim an empty one for it. Returns nullptr if every entry holds another key. If the
+    // caller already reserved the entry in size, claimed tells whether an empty entry was taken.
+    Entry* claim(Table* table, KeyType key, bool reserved = false, bool* claimed = nullptr) const
+    {
+        std::size_t index = table->hash(key);
+        for (std::size_t examined = 0; examined < table->capacity; ++examined)
+        {
+            Entry& entry = table->entries[index];
+            KeyType entry_key = entry.key.load(std::memory_order_acquire);
+            if (entry_key == NO_KEY &&
+                entry.key.compare_exchange_strong(entry_key, key, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                if (reserved)
+                    *claimed = true;
+                else if (table->over_threshold(table->size.fetch_add(1, std::memory_order_relaxed) + 1))
+                    start_resize(table, table->successor_capacity());
+                return &entry;
+            }
+            // Also covers losing the race for an empty entry against the same key
+            if (entry_key == key)
+                return &entry;
+            index = table->next_probe(index);
+        }
+        return nullptr;
+    }
+
+    // claim() for a writer. In a successor that is still being filled, a new key is only claimed after reserving its
+    // entry, so the entries left to migrate always fit in as well.
+    Entry* claim_for_insert(Table* table, KeyType key) const
+    {
+        while (true)
+        {
+            // Only the current table has a successor, so a table that is being filled is the successor of current
+            Table* predecessor = current.load(std::memory_order_acquire);
+            if (predecessor == table || predecessor->next.load(std::memory_order_acquire) != table)
+                return claim(table, key);
+            if (Entry* entry = find(table, key))
+                return entry;
+            // Entries of chunks in progress are counted both here and in size if they were copied already, which
+            // only makes the reservation more cautious
+            const std::size_t pending = predecessor->capacity - predecessor->migrated.load(std::memory_order_acquire);
+            if (table->size.fetch_add(1, std::memory_order_relaxed) + 1 + pending <= table->capacity)
+            {
+                bool claimed = false;
+                Entry* entry = claim(table, key, true, &claimed);
+                if (!claimed)
+                    table->size.fetch_sub(1, std::memory_order_relaxed);
+                return entry;
+            }
+            table->size.fetch_sub(1, std::memory_order_relaxed);
+            help_migrate(predecessor);
+            // Every chunk is taken; waits for their owners, see the progress notes of the class
+            if (predecessor->migration_cursor.load(std::memory_order_relaxed) >= predecessor->capacity)
+                std::this_thread::yield();
+        }
+    }
+
+    // Allocate the successor of table. Only the current table is resized, a successor that is still being filled
+    // by a migration waits until it became current itself.
+    void start_resize(Table* table, std::size_t capacity) const
+    {
+        if (table->next.load(std::memory_order_acquire) || current.load(std::memory_order_acquire) != table)
+            return;
+        auto* next = new Table(capacity);
+        Table* expected = nullptr;
+        if (!table->next.compare_exchange_strong(expected, next, std::memory_order_acq_rel))
+            delete next;
+    }
+
+    // Called if table is full. Returns the table the insert has to continue in.
+    Table* grow(Table* table) const
+    {
+        if (Table* next = table->next.load(std::memory_order_acquire))
+            return next;
+        while (current.load(std::memory_order_acquire) != table)
+        {
+            // The previous migration still fills table; all chunks may already be handed out to other threads
+            help_migrate(current.load(std::memory_order_acquire));
+            std::this_thread::yield();
+        }
+        start_resize(table, table->successor_capacity());
+        return table->next.load(std::memory_order_acquire);
+    }
+
+    // Copy one entry into the successor, then freeze it. Only ever called by the thread owning the entry's chunk.
+    // Tombstones are not copied, unless the value was erased after an earlier copy of this entry.
+    void migrate_entry(Entry& entry, Table* next) const
+    {
+        ValueType value = entry.value.load(std::memory_order_acquire);
+        Entry* target = nullptr;
+        while (true)
+        {
+            if (value != NO_VALUE || target)
+            {
+                if (!target)
+                {
+                    // Cannot fail: writers only claim new keys in next after reserving them next to the entries left
+                    // to migrate, see claim_for_insert()
+                    target = claim(next, entry.key.load(std::memory_order_acquire));
+                }
+                // Nobody else writes target before the entry is frozen
+                const ValueType previous = target->value.exchange(value, std::memory_order_acq_rel);
+                if ((previous == NO_VALUE) != (value == NO_VALUE))
+                {
+                    if (value == NO_VALUE)
+                        next->live.fetch_sub(1, std::memory_order_relaxed);
+                    else
+                        next->live.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            if (entry.value.compare_exchange_weak(value, MOVED_VALUE, std::memory_order_acq_rel,
+                                                  std::memory_order_acquire))
+                return;
+        }
+    }
+
+    // Migrate one chunk of table if it is being resized; promote the successor once the last chunk is done.
+    void help_migrate(Table* table) const
+    {
+        Table* next = table->next.load(std::memory_order_acquire);
+        if (!next || table->migration_cursor.load(std::memory_order_relaxed) >= table->capacity)
+            return;
+        const std::size_t begin = table->migration_cursor.fetch_add(hash_table_migration_chunk,
+                                                                    std::memory_order_relaxed);
+        if (begin >= table->capacity)
+            return;
+        const std::size_t end = std::min(begin + hash_table_migration_chunk, table->capacity);
+        for (std::size_t index = begin; index < end; ++index)
+            migrate_entry(table->entries[index], next);
+        if (table->migrated.fetch_add(end - begin, std::memory_order_acq_rel) + (end - begin) == table->capacity)
+        {
+            Table* expected = table;
+            if (current.compare_exchange_strong(expected, next, std::memory_order_acq_rel))
+                retired_tables.retire(table);
+            // The successor may have passed its threshold while it was filled
+            if (next->over_threshold(next->size.load(std::memory_order_relaxed)))
+                start_resize(next, next->successor_capacity());
+        }
+    }
+};
+
+#endif //RESIZABLE_LOCK_FREE_HASH_TABLE_H
@@ -4,59 +4,187 @@
 
 #ifndef RECLAMATION_H
 #define RECLAMATION_H
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "asymmetric_fence.h"
+#include "hazard_pointer.h"
 
-template <typename Node, typename Deleter = std::default_delete<Node>>
+/// A scan is triggered once the number of retired nodes exceeds this multiple of the active hazard pointers.
+constexpr std::size_t retire_scan_multiplier = 2;
+/// Lower bound for the scan threshold, so that a single thread does not scan on every retire.
+constexpr std::size_t retire_scan_minimum = 64;
+
+/**
+ * @struct RetireListHook
+ * @brief Intrusive link a node has to carry to be retired without an extra allocation.
+ *
+ * Nodes derive from RetireListHook<Node>; the link is only used once the node is unlinked from its
+ * data structure.
+ */
+template <typename Node>
+struct RetireListHook
+{
+    Node* retired_next{nullptr};
+};
+
+/**
+ * @class RetireList
+ * @brief Deferred deletion of nodes that may still be referenced by hazard pointers.
+ *
+ * Every thread owns a private list of retired nodes per node type, so retiring never touches shared state.
+ * When a thread exits, the nodes it could not delete yet are handed over to a shared orphan list, which is
+ * adopted by the next thread that scans.
+ *
+ * @tparam AsymmetricFence Set if the hazard pointers of the nodes are published with a light asymmetric fence;
+ * every scan then issues the heavy counterpart first.
+ */
+template <typename Node, typename Deleter = std::default_delete<Node>, bool AsymmetricFence = false>
 class RetireList
 {
-    struct RetiredNode
+    /**
+     * @struct OrphanList
+     * @brief Nodes left behind by exited threads. Whatever is left at program exit is deleted.
+     */
+    struct OrphanList
     {
-        Node* node;
-        RetiredNode* next;
+        std::atomic<Node*> head{nullptr};
 
-        explicit RetiredNode(Node* p) : node(p), next(nullptr)
+        ~OrphanList()
         {
+            Node* current = head.exchange(nullptr);
+            while (current)
+            {
+                Node* const next = current->retired_next;
+                Deleter{}(current);
+                current = next;
+            }
         }
 
-        ~RetiredNode()
+        // Splice a whole chain [first, last] onto the orphans with a single successful CAS.
+        void add(Node* first, Node* last)
         {
-            Deleter{}(node);
+            last->retired_next = head.load(std::memory_order_relaxed);
+            while (!head.compare_exchange_weak(last->retired_next, first, std::memory_order_release,
+                                               std::memory_order_relaxed));
         }
     };
 
-    std::atomic<RetiredNode*> RetiredNodes;
+    /**
+     * @struct ThreadRetireList
+     * @brief The calling thread's retired nodes. Only ever accessed by its owning thread.
+     */
+    struct ThreadRetireList
+    {
+        Node* head{nullptr};
+        std::size_t count{};
+        std::vector<void*> snapshot;
+
+        ~ThreadRetireList()
+        {
+            scan(*this);
+            if (head)
+            {
+                Node* last = head;
+                while (last->retired_next)
+                    last = last->retired_next;
+                orphans.add(head, last);
+            }
+        }
+
+        void add(Node* node)
+        {
+            node->retired_next = head;
+            head = node;
+            ++count;
+        }
+    };
+
+    static inline OrphanList orphans;
+    static inline thread_local ThreadRetireList local_list;
+
+    static std::size_t scan_threshold()
+    {
+        return std::max(retire_scan_minimum, retire_scan_multiplier * hazard_pointer_domain.active_slots());
+    }
+
+    // Copy all currently published hazard pointers into a sorted vector, so that each retired node
+    // is checked with a binary search instead of loading every slot again.
+    static void snapshot_hazard_pointers(std::vector<void*>& snapshot)
+    {
+        snapshot.clear();
+        hazard_pointer_domain.for_each_hazard_pointer([&snapshot](void* pointer) { snapshot.push_back(pointer); });
+        std::sort(snapshot.begin(), snapshot.end());
+    }
 
-    void add_to_retired_nodes(RetiredNode* retiredNode)
+    // Adopt the orphans, delete all nodes no hazard pointer references and keep the others.
+    static void scan(ThreadRetireList& list)
     {
-        retiredNode->next = RetiredNodes.load();
-        while (!RetiredNodes.compare_exchange_strong(retiredNode->next, retiredNode));
+        if (orphans.head.load(std::memory_order_relaxed))
+        {
+            Node* orphan = orphans.head.exchange(nullptr, std::memory_order_acquire);
+            while (orphan)
+            {
+                Node* const next = orphan->retired_next;
+                list.add(orphan);
+                orphan = next;
+            }
+        }
+        if (!list.head)
+            return;
+
+        if constexpr (AsymmetricFence)
+            asymmetric_thread_fence_heavy();
+        auto& snapshot = list.snapshot;
+        snapshot_hazard_pointers(snapshot);
+        Node* current = list.head;
+        list.head = nullptr;
+        list.count = 0;
+        while (current)
+        {
+            Node* const next = current->retired_next;
+            if (std::binary_search(snapshot.begin(), snapshot.end(), static_cast<void*>(current)))
+                list.add(current);
+            else
+                Deleter{}(current);
+            current = next;
+        }
     }
 
 public:
     bool is_in_use(Node* node)
     {
-        for (auto& hp : hazard_pointers)
+        if constexpr (AsymmetricFence)
+            asymmetric_thread_fence_heavy();
+        bool in_use = false;
+        hazard_pointer_domain.for_each_hazard_pointer([&in_use, node](void* pointer)
         {
-            if (hp.pointer.load() == node)
-                return true;
-        }
-        return false;
+            in_use |= pointer == static_cast<void*>(node);
+        });
+        return in_use;
     }
 
     void add_node(Node* node)
     {
-        add_to_retired_nodes(new RetiredNode(node));
+        local_list.add(node);
     }
 
+    // Delete the calling thread's retired nodes that are no longer referenced by any hazard pointer.
     void delete_unused_nodes()
     {
-        RetiredNode* current = RetiredNodes.exchange(nullptr);
-        while (current)
-        {
-            RetiredNode* const next = current->next;
-            if (!is_in_use(current->node)) delete current;
-            else add_to_retired_nodes(current);
-            current = next;
-        }
+        scan(local_list);
+    }
+
+    // Defer the deletion of the node. Only once enough nodes are retired by this thread, all of them are
+    // checked against one snapshot of the hazard pointers, which amortizes the cost of a scan over many retires.
+    void retire(Node* node)
+    {
+        ThreadRetireList& list = local_list;
+        list.add(node);
+        if (list.count >= scan_threshold())
+            scan(list);
     }
 };
 
@@ -0,0 +1,450 @@
+//
+// Created by andreas on 18.10.26.
+//
+
+#ifndef SHARDED_CONCURRENT_MAP_H
+#define SHARDED_CONCURRENT_MAP_H
+// Lock-free map for arbitrary keys and values, e.g. string-keyed caches. LockFreeHashTable stays the fast path for
+// integral keys and small values with reserved sentinels and a known problem size.
+// The map does not switch to LockFreeHashTable for integral keys on its own: that table is sized at compile time and
+// lets insert() fail once it is full, reserves NO_KEY and NO_VALUE, and only reclaims erased entries in compact()
+// while no other thread uses it. None of these fit the interface here, so callers that meet them pick the table
+// directly; benchmark_concurrent_map.cpp compares the two on integral keys.
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include "cache_line.h"
+#include "hash_policy.h"
+#include "hazard_pointer_reclamation.h"
+
+/// Number of shards of a map constructed without an explicit count.
+constexpr std::size_t concurrent_map_default_shards = 16;
+/// A shard doubles its number of buckets once it holds more than this many entries per bucket.
+constexpr std::size_t concurrent_map_max_load = 2;
+
+/**
+ * @class ShardedConcurrentMap
+ * @brief Lock-free hash map with a split-ordered list per shard (Shalev and Shavit).
+ *
+ * The high bits of the hash select a shard. Every shard keeps all its entries in one lock-free linked list (Michael's
+ * algorithm) sorted by the bit-reversed hash, so the entries of a bucket are contiguous and a bucket splits into two
+ * when the number of buckets doubles, without moving a single entry. A bucket is a pointer to a dummy node in the list;
+ * it is created on first use by inserting the dummy behind the dummy of its parent bucket. Bucket arrays grow in
+ * segments that are never moved either, so growing a shard is one CAS on its bucket count.
+ *
+ * Removed nodes and replaced values are reclaimed through Reclamation, hazard pointers by default: a traversal
+ * protects the predecessor, the current and the next node in slots 0 to 2, a value being copied out in slot 3.
+ * Values of a type that std::atomic supports lock-free are stored in the node itself and replaced with one store,
+ * other values are held in a separately allocated box that is swapped and retired on every assignment.
+ *
+ * @tparam Hash Hash of the keys; its result is mixed with MixingHash, since std::hash of an integer is the identity.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>,
+          typename Reclamation = HazardPointerReclamation>
+    requires std::copy_constructible<Value>
+class ShardedConcurrentMap
+{
+    using Guard = typename Reclamation::Guard;
+
+    // Only instantiated for trivially copyable types, std::atomic rejects all others
+    template <typename T>
+    struct is_lock_free_atomic : std::bool_constant<std::atomic<T>::is_always_lock_free>
+    {
+    };
+
+    static constexpr bool inline_values = std::conjunction_v<std::is_trivially_copyable<Value>,
+                                                             is_lock_free_atomic<Value>>;
+
+    /**
+     * @struct Node
+     * @brief List node. Bucket dummies are plain nodes with an even order, entries are DataNodes with an odd one.
+     */
+    struct Node
+    {
+        /// Bit-reversed hash, the sort key of the list.
+        const std::uint64_t order;
+        /// Successor; the lowest bit is set once this node is logically removed.
+        std::atomic<Node*> next{nullptr};
+
+        explicit Node(std::uint64_t order) : order(order)
+        {
+        }
+    };
+
+    struct ValueBox : RetireListHook<ValueBox>
+    {
+        Value value;
+
+        explicit ValueBox(Value value) : value(std::move(value))
+        {
+        }
+    };
+
+    using ValueSlot = std::conditional_t<inline_values, std::atomic<Value>, std::atomic<ValueBox*>>;
+
+    struct DataNode : Node, RetireListHook<DataNode>
+    {
+        const Key key;
+        ValueSlot value;
+
+        DataNode(std::uint64_t order, Key key, Value initial) : Node(order), key(std::move(key))
+        {
+            if constexpr (inline_values)
+                value.store(initial, std::memory_order_relaxed);
+            else
+                value.store(new ValueBox(std::move(initial)), std::memory_order_relaxed);
+        }
+
+        ~DataNode()
+        {
+            if constexpr (!inline_values)
+                delete value.load(std::memory_order_relaxed);
+        }
+    };
+
+    struct Guards
+    {
+        Guard next{0};
+        Guard current{1};
+        Guard previous{2};
+    };
+
+    // Where a search ended: current is the first node not ordered before the searched one, previous links to it.
+    struct Position
+    {
+        std::atomic<Node*>* previous;
+        Node* current;
+    };
+
+    /**
+     * @struct Shard
+     * @brief One split-ordered list with its buckets.
+     */
+    struct alignas(cache_line_size) Shard
+    {
+        // Segment 0 holds bucket 0, segment s > 0 the buckets [2^(s-1), 2^s)
+        static constexpr std::size_t segment_count = 64;
+        std::atomic<std::atomic<Node*>*> segments[segment_count]{};
+        std::atomic<std::size_t> bucket_count{2};
+        alignas(cache_line_size) std::atomic<std::size_t> size{0};
+
+        Shard()
+        {
+            bucket(0).store(new Node(0), std::memory_order_relaxed);
+        }
+
+        Shard(const Shard&) = delete;
+        Shard& operator=(const Shard&) = delete;
+
+        ~Shard()
+        {
+            Node* node = bucket(0).load(std::memory_order_relaxed);
+            while (node)
+            {
+                Node* const next = unmarked(node->next.load(std::memory_order_relaxed));
+                if (node->order & 1)
+                    delete static_cast<DataNode*>(node);
+                else
+                    delete node;
+                node = next;
+            }
+            for (auto& segment : segments)
+                delete[] segment.load(std::memory_order_relaxed);
+        }
+
+        std::atomic<Node*>& bucket(std::size_t index)
+        {
+            const auto segment_index = static_cast<std::size_t>(std::bit_width(index));
+            const std::size_t first = segment_index == 0 ? 0 : std::size_t{1} << (segment_index - 1);
+            std::atomic<Node*>* segment = segments[segment_index].load(std::memory_order_acquire);
+            if (!segment)
+            {
+                const std::size_t length = segment_index == 0 ? 1 : first;
+                auto* allocated = new std::atomic<Node*>[length]();
+                if (segments[segment_index].compare_exchange_strong(segment, allocated, std::memory_order_acq_rel))
+                    segment = allocated;
+                else
+                    delete[] allocated;
+            }
+            return segment[index - first];
+        }
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    const unsigned shard_bits;
+    // Lookups unlink removed nodes they pass as well
+    mutable typename Reclamation::template retire_list<DataNode> retired_nodes;
+    typename Reclamation::template retire_list<ValueBox> retired_values;
+
+    static bool is_marked(Node* pointer)
+    {
+        return reinterpret_cast<std::uintptr_t>(pointer) & 1;
+    }
+
+    static Node* marked(Node* pointer)
+    {
+        return reinterpret_cast<Node*>(reinterpret_cast<std::uintptr_t>(pointer) | 1);
+    }
+
+    static Node* unmarked(Node* pointer)
+    {
+        return reinterpret_cast<Node*>(reinterpret_cast<std::uintptr_t>(pointer) & ~std::uintptr_t{1});
+    }
+
+    static std::uint64_t reverse_bits(std::uint64_t x)
+    {
+        x = (x >> 1 & 0x5555555555555555ULL) | (x & 0x5555555555555555ULL) << 1;
+        x = (x >> 2 & 0x3333333333333333ULL) | (x & 0x3333333333333333ULL) << 2;
+        x = (x >> 4 & 0x0f0f0f0f0f0f0f0fULL) | (x & 0x0f0f0f0f0f0f0f0fULL) << 4;
+        x = (x >> 8 & 0x00ff00ff00ff00ffULL) | (x & 0x00ff00ff00ff00ffULL) << 8;
+        x = (x >> 16 & 0x0000ffff0000ffffULL) | (x & 0x0000ffff0000ffffULL) << 16;
+        return x >> 32 | x << 32;
+    }
+
+    static std::uint64_t data_order(std::uint64_t hash_value)
+    {
+        return reverse_bits(hash_value) | 1;
+    }
+
+    static std::uint64_t dummy_order(std::size_t bucket)
+    {
+        return reverse_bits(bucket);
+    }
+
+    static std::uint64_t hash(const Key& key)
+    {
+        return MixingHash<std::uint64_t>{}(static_cast<std::uint64_t>(Hash{}(key)));
+    }
+
+    Shard& shard_of(std::uint64_t hash_value) const
+    {
+        return shards[shard_bits == 0 ? 0 : hash_value >> (64 - shard_bits)];
+    }
+
+    /**
+     * @brief Search the list starting at head for the node of order and key (nullptr for a dummy).
+     *
+     * Unlinks and retires the logically removed nodes it passes. On return, position.current is protected by
+     * guards.current and the node owning position.previous by guards.previous.
+     */
+    bool find(Node* head, std::uint64_t order, const Key* key, Guards& guards, Position& position) const
+    {
+    retry:
+        std::atomic<Node*>* previous = &head->next;
+        Node* current = previous->load();
+        guards.current.publish(current);
+        if (previous->load() != current)
+            goto retry;
+        while (true)
+        {
+            if (!current)
+            {
+                position = {previous, nullptr};
+                return false;
+            }
+            Node* const next = current->next.load();
+            guards.next.publish(unmarked(next));
+            if (current->next.load() != next || previous->load() != current)
+                goto retry;
+            if (!is_marked(next))
+            {
+                if (current->order > order)
+                {
+                    position = {previous, current};
+                    return false;
+                }
+                if (current->order == order &&
+                    (!key || KeyEqual{}(static_cast<DataNode*>(current)->key, *key)))
+                {
+                    position = {previous, current};
+                    return true;
+                }
+                previous = &current->next;
+                guards.previous.publish(current);
+            }
+            else
+            {
+                Node* expected = current;
+                if (!previous->compare_exchange_strong(expected, unmarked(next)))
+                    goto retry;
+                retired_nodes.retire(static_cast<DataNode*>(current));
+            }
+            current = unmarked(next);
+            // Still protected by guards.next
+            guards.current.publish(current);
+        }
+    }
+
+    Node* initialize_bucket(Shard& shard, std::size_t index) const
+    {
+        const std::size_t parent = index ^ std::bit_floor(index);
+        Node* parent_head = shard.bucket(parent).load();
+        if (!parent_head)
+            parent_head = initialize_bucket(shard, parent);
+        auto* dummy = new Node(dummy_order(index));
+        Guards guards;
+        Position position{};
+        while (true)
+        {
+            if (find(parent_head, dummy->order, nullptr, guards, position))
+            {
+                // Dummies are never removed, so the one inserted by another thread stays valid
+                delete dummy;
+                dummy = position.current;
+                break;
+            }
+            dummy->next.store(position.current);
+            Node* expected = position.current;
+            if (position.previous->compare_exchange_strong(expected, dummy))
+                break;
+        }
+        shard.bucket(index).store(dummy);
+        return dummy;
+    }
+
+    Node* bucket_head(Shard& shard, std::uint64_t hash_value) const
+    {
+        const std::size_t index = hash_value & (shard.bucket_count.load(std::memory_order_acquire) - 1);
+        Node* head = shard.bucket(index).load();
+        return head ? head : initialize_bucket(shard, index);
+    }
+
+    void assign(DataNode* node, Value value)
+    {
+        if constexpr (inline_values)
+        {
+            node->value.store(value);
+        }
+        else
+        {
+            ValueBox* const replaced = node->value.exchange(new ValueBox(std::move(value)));
+            retired_values.retire(replaced);
+        }
+    }
+
+public:
+    /**
+     * @param shard_count Number of shards, rounded up to a power of two.
+     */
+    explicit ShardedConcurrentMap(std::size_t shard_count = concurrent_map_default_shards)
+        : shards(new Shard[std::bit_ceil(std::max<std::size_t>(shard_count, 1))]),
+          shard_bits(static_cast<unsigned>(std::countr_zero(std::bit_ceil(std::max<std::size_t>(shard_count, 1)))))
+    {
+    }
+
+    ShardedConcurrentMap(const ShardedConcurrentMap&) = delete;
+    ShardedConcurrentMap& operator=(const ShardedConcurrentMap&) = delete;
+
+    /**
+     * @brief Insert key with value, or replace the value if key is present.
+     * @return true if key was inserted, false if its value was replaced.
+     */
+    bool insert_or_assign(const Key& key, Value value)
+    {
+        const std::uint64_t hash_value = hash(key);
+        Shard& shard = shard_of(hash_value);
+        Node* const head = bucket_head(shard, hash_value);
+        const std::uint64_t order = data_order(hash_value);
+        Guards guards;
+        Position position{};
+        DataNode* node = nullptr;
+        while (true)
+        {
+            if (find(head, order, &key, guards, position))
+            {
+                assign(static_cast<DataNode*>(position.current), value);
+                // An erase that marked the node in the meantime may have removed it before the new value arrived,
+                // then the key is inserted again
+                if (!is_marked(position.current->next.load()))
+                {
+                    delete node;
+                    return false;
+                }
+                continue;
+            }
+            if (!node)
+                node = new DataNode(order, key, value);
+            node->next.store(position.current);
+            Node* expected = position.current;
+            if (position.previous->compare_exchange_strong(expected, node))
+                break;
+        }
+        const std::size_t size = shard.size.fetch_add(1, std::memory_order_relaxed) + 1;
+        std::size_t buckets = shard.bucket_count.load(std::memory_order_relaxed);
+        if (size > buckets * concurrent_map_max_load)
+            shard.bucket_count.compare_exchange_strong(buckets, buckets * 2, std::memory_order_acq_rel);
+        return true;
+    }
+
+    /**
+     * @return A copy of the value of key, or std::nullopt if key is not present.
+     */
+    std::optional<Value> lookup(const Key& key) const
+    {
+        const std::uint64_t hash_value = hash(key);
+        Shard& shard = shard_of(hash_value);
+        Guards guards;
+        Position position{};
+        if (!find(bucket_head(shard, hash_value), data_order(hash_value), &key, guards, position))
+            return std::nullopt;
+        auto* node = static_cast<DataNode*>(position.current);
+        if constexpr (inline_values)
+        {
+            return node->value.load();
+        }
+        else
+        {
+            Guard value_guard(3);
+            return value_guard.protect(node->value)->value;
+        }
+    }
+
+    /**
+     * @return true if key was present and is removed now.
+     */
+    bool erase(const Key& key)
+    {
+        const std::uint64_t hash_value = hash(key);
+        Shard& shard = shard_of(hash_value);
+        Node* const head = bucket_head(shard, hash_value);
+        const std::uint64_t order = data_order(hash_value);
+        Guards guards;
+        Position position{};
+        while (true)
+        {
+            if (!find(head, order, &key, guards, position))
+                return false;
+            Node* const current = position.current;
+            Node* next = current->next.load();
+            // Whoever sets the mark removes the key
+            if (is_marked(next) || !current->next.compare_exchange_strong(next, marked(next)))
+                continue;
+            Node* expected = current;
+            if (position.previous->compare_exchange_strong(expected, next))
+                retired_nodes.retire(static_cast<DataNode*>(current));
+            else
+                find(head, order, &key, guards, position);
+            shard.size.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    /**
+     * @brief Number of entries. Only exact while no other thread modifies the map.
+     */
+    std::size_t size() const
+    {
+        std::size_t total{};
+        for (std::size_t shard = 0; shard < std::size_t{1} << shard_bits; ++shard)
+            total += shards[shard].size.load(std::memory_order_relaxed);
+        return total;
+    }
+};
+
+#endif //SHARDED_CONCURRENT_MAP_H
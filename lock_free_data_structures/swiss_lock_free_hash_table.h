@@ -0,0 +1,242 @@
+//
+// Created by andreas on 18.10.26.
+//
+
+#ifndef SWISS_LOCK_FREE_HASH_TABLE_H
+#define SWISS_LOCK_FREE_HASH_TABLE_H
+// Variant of LockFreeHashTable with the group layout of Swiss tables: the entries are split into groups of 16, and every
+// group starts with 16 control bytes holding a 7-bit fingerprint of the key in each used entry. A lookup compares the
+// fingerprint with all control bytes of a group at once and only loads the keys of the matching entries, so at high
+// load factors a probe sequence costs a few group compares instead of a key load per entry.
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "hash_policy.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/// Number of entries sharing one block of control bytes.
+constexpr std::size_t swiss_group_width = 16;
+
+/**
+ * @class SwissControlGroup
+ * @brief The 16 control bytes of a group, stored in two atomic words so they can be loaded without a data race.
+ *
+ * Byte i of the group is byte i % 8 of word i / 8, counted from the least significant end. An empty entry has the high
+ * bit of its control byte set, a used one holds the low 7 bits of the key's hash.
+ */
+struct alignas(16) SwissControlGroup
+{
+    static constexpr std::uint8_t empty = 0x80;
+    static constexpr std::uint64_t all_empty = 0x8080808080808080ULL;
+
+    std::atomic<std::uint64_t> words[2]{all_empty, all_empty};
+
+    /**
+     * @brief Bit i of the result is set if control byte i equals fingerprint.
+     */
+    static std::uint32_t match(std::uint64_t low, std::uint64_t high, std::uint8_t fingerprint)
+    {
+#ifdef __SSE2__
+        const __m128i control = _mm_set_epi64x(static_cast<long long>(high), static_cast<long long>(low));
+        const __m128i equal = _mm_cmpeq_epi8(control, _mm_set1_epi8(static_cast<char>(fingerprint)));
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(equal));
+#else
+        return match_word(low, fingerprint) | match_word(high, fingerprint) << 8;
+#endif
+    }
+
+    /**
+     * @brief Bit i of the result is set if entry i is empty.
+     */
+    static std::uint32_t match_empty(std::uint64_t low, std::uint64_t high)
+    {
+#ifdef __SSE2__
+        const __m128i control = _mm_set_epi64x(static_cast<long long>(high), static_cast<long long>(low));
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(control));
+#else
+        return high_bits(low) | high_bits(high) << 8;
+#endif
+    }
+
+    /**
+     * @brief Turn the empty control byte of entry index into fingerprint. Only the owner of the entry may call this.
+     */
+    void publish(std::size_t index, std::uint8_t fingerprint)
+    {
+        const std::uint64_t flip = std::uint64_t(empty ^ fingerprint) << (index % 8 * 8);
+        words[index / 8].fetch_xor(flip, std::memory_order_release);
+    }
+
+private:
+    // Gather the high bit of each byte into the low 8 bits
+    static std::uint32_t high_bits(std::uint64_t word)
+    {
+        return static_cast<std::uint32_t>(((word & all_empty) * 0x0002040810204081ULL) >> 56);
+    }
+
+    // Bytes of word equal to fingerprint. A byte above a match may be reported as well, the keys are compared anyway.
+    static std::uint32_t match_word(std::uint64_t word, std::uint8_t fingerprint)
+    {
+        constexpr std::uint64_t ones = 0x0101010101010101ULL;
+        const std::uint64_t x = word ^ (ones * fingerprint);
+        return high_bits((x - ones) & ~x);
+    }
+};
+
+/**
+ * @class SwissLockFreeHashTable
+ * @brief Lock-free open addressing hash table probing groups of 16 entries with one SIMD compare.
+ *
+ * An insert claims an entry with a CAS on its key, like LockFreeHashTable, stores the value and only then publishes the
+ * fingerprint in the control byte with one atomic xor. Keys and control bytes only ever change from empty to used, so
+ * the first entry of the probe sequence whose key is empty or equal is the same for all threads and a key is never
+ * stored twice. A lookup matches the fingerprint against the published control bytes of a group. It stops at a group
+ * with an empty control byte whose key is empty as well; an entry that is claimed but not yet published is compared by
+ * its key.
+ *
+ * Groups are probed linearly. The SIMD compare uses SSE2 where available (every x86-64 target) and falls back to
+ * 64-bit word arithmetic otherwise.
+ *
+ * @tparam TableSize Number of entries, a multiple of the group width.
+ * @tparam Hasher Hash policy, see hash_policy.h. The low 7 bits of the hash are the fingerprint, the others pick the group.
+ */
+template <typename KeyType, typename ValueType, KeyType NO_KEY, ValueType NO_VALUE, size_t TableSize,
+          typename Hasher = MixingHash<KeyType>>
+requires std::is_integral_v<KeyType> && std::is_trivially_copyable_v<ValueType>
+class SwissLockFreeHashTable
+{
+    static_assert(TableSize % swiss_group_width == 0, "the table size has to be a multiple of the group width");
+    static constexpr size_t group_count = TableSize / swiss_group_width;
+
+public:
+    static constexpr KeyType no_key = NO_KEY;
+    static constexpr ValueType no_value = NO_VALUE;
+    struct Entry
+    {
+        std::atomic<KeyType> key{NO_KEY};
+        std::atomic<ValueType> value{NO_VALUE};
+    };
+
+    SwissLockFreeHashTable() : groups(group_count)
+    {
+    }
+
+    bool insert(KeyType key, ValueType value)
+    {
+        const size_t hash_value = Hasher{}(key);
+        const std::uint8_t fingerprint = fingerprint_of(hash_value);
+        size_t group_index = group_of(hash_value);
+        for (size_t groups_examined = 0; groups_examined < group_count; ++groups_examined)
+        {
+            Group& group = groups[group_index];
+            const std::uint64_t low = group.control.words[0].load(std::memory_order_acquire);
+            const std::uint64_t high = group.control.words[1].load(std::memory_order_acquire);
+            for (std::uint32_t matches = SwissControlGroup::match(low, high, fingerprint); matches; matches &= matches - 1)
+            {
+                Entry& entry = group.entries[std::countr_zero(matches)];
+                if (entry.key.load(std::memory_order_acquire) == key)
+                {
+                    entry.value.store(value, std::memory_order_release);
+                    return true;
+                }
+            }
+            // Published entries hold other keys now, only the unpublished ones can still become ours
+            for (std::uint32_t empty = SwissControlGroup::match_empty(low, high); empty; empty &= empty - 1)
+            {
+                const auto index = static_cast<size_t>(std::countr_zero(empty));
+                Entry& entry = group.entries[index];
+                KeyType expected = NO_KEY;
+                if (entry.key.compare_exchange_strong(expected, key, std::memory_order_acq_rel,
+                                                      std::memory_order_acquire))
+                {
+                    entry.value.store(value, std::memory_order_release);
+                    group.control.publish(index, fingerprint);
+                    return true;
+                }
+                // Lost against an insert of the same key that has not published its fingerprint yet
+                if (expected == key)
+                {
+                    entry.value.store(value, std::memory_order_release);
+                    return true;
+                }
+            }
+            group_index = next_probe<group_count>(group_index);
+        }
+        return false;
+    }
+
+    ValueType lookup(KeyType key) const
+    {
+        const Entry* entry = find(key);
+        return entry ? entry->value.load(std::memory_order_acquire) : no_value;
+    }
+
+    /**
+     * @brief Number of groups a lookup of key examines, including the one that ends the probe sequence.
+     */
+    size_t probe_length(KeyType key) const
+    {
+        size_t groups_examined{};
+        find(key, &groups_examined);
+        return groups_examined;
+    }
+
+private:
+    struct Group
+    {
+        SwissControlGroup control;
+        Entry entries[swiss_group_width];
+    };
+
+    std::vector<Group> groups;
+
+    static std::uint8_t fingerprint_of(size_t hash_value)
+    {
+        return static_cast<std::uint8_t>(hash_value & 0x7f);
+    }
+
+    static size_t group_of(size_t hash_value)
+    {
+        return reduce_hash<group_count>(hash_value >> 7);
+    }
+
+    const Entry* find(KeyType key, size_t* groups_examined = nullptr) const
+    {
+        const size_t hash_value = Hasher{}(key);
+        const std::uint8_t fingerprint = fingerprint_of(hash_value);
+        size_t group_index = group_of(hash_value);
+        for (size_t examined = 1; examined <= group_count; ++examined)
+        {
+            if (groups_examined)
+                *groups_examined = examined;
+            const Group& group = groups[group_index];
+            const std::uint64_t low = group.control.words[0].load(std::memory_order_acquire);
+            const std::uint64_t high = group.control.words[1].load(std::memory_order_acquire);
+            for (std::uint32_t matches = SwissControlGroup::match(low, high, fingerprint); matches; matches &= matches - 1)
+            {
+                const Entry& entry = group.entries[std::countr_zero(matches)];
+                if (entry.key.load(std::memory_order_acquire) == key)
+                    return &entry;
+            }
+            for (std::uint32_t empty = SwissControlGroup::match_empty(low, high); empty; empty &= empty - 1)
+            {
+                const Entry& entry = group.entries[std::countr_zero(empty)];
+                const KeyType entry_key = entry.key.load(std::memory_order_acquire);
+                if (entry_key == NO_KEY)
+                    return nullptr;
+                // Claimed, but the fingerprint is not published yet
+                if (entry_key == key)
+                    return &entry;
+            }
+            group_index = next_probe<group_count>(group_index);
+        }
+        return nullptr;
+    }
+};
+
+#endif //SWISS_LOCK_FREE_HASH_TABLE_H
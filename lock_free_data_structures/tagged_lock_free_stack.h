@@ -0,0 +1,165 @@
+//
+// Created by andreas on 18.10.26.
+//
+
+#ifndef TAGGED_LOCK_FREE_STACK_H
+#define TAGGED_LOCK_FREE_STACK_H
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+
+/// Number of low bits of a tagged word holding the pointer. x86-64 and AArch64 user-space addresses fit in 48 bits.
+constexpr unsigned tagged_pointer_bits = 48;
+
+/**
+ * @class TaggedPointerList
+ * @brief Treiber stack of nodes whose head packs a 48-bit pointer and a 16-bit modification tag into one word.
+ *
+ * Every successful CAS increments the tag, so a head that was popped and pushed again in between
+ * (the ABA problem) no longer compares equal. This is only sound if popped nodes stay readable: pop()
+ * dereferences the head after another thread might have popped it, which is why the nodes must be type-stable,
+ * i.e. recycled but never freed while any thread can still use the list.
+ *
+ * The packing assumes that user-space addresses fit into 48 bits with the upper 16 bits zero, as on x86-64 with
+ * 4-level paging and on AArch64 with 48-bit virtual addresses. It breaks with 5-level paging (LA57) once the kernel
+ * hands out addresses above 2^47, and with pointer tagging such as ARM TBI/MTE or Intel LAM. push() checks every node
+ * and aborts the program on an address that does not fit, also in release builds, instead of corrupting the list.
+ *
+ * @tparam Node Node type with a member std::atomic<Node*> next.
+ */
+template <typename Node>
+class TaggedPointerList
+{
+    static constexpr std::uint64_t pointer_mask = (std::uint64_t{1} << tagged_pointer_bits) - 1;
+
+    std::atomic<std::uint64_t> head{0};
+
+    static Node* pointer_of(std::uint64_t word)
+    {
+        return reinterpret_cast<Node*>(word & pointer_mask);
+    }
+
+    static std::uint64_t next_word(std::uint64_t word, Node* pointer)
+    {
+        return ((word >> tagged_pointer_bits) + 1) << tagged_pointer_bits | reinterpret_cast<std::uint64_t>(pointer);
+    }
+
+public:
+    void push(Node* node)
+    {
+        // Every pointer in a word was pushed once, so checking here covers pop() as well. Truncating the address
+        // would hand out a wrong node later, which is far harder to track down than the abort.
+        if (reinterpret_cast<std::uint64_t>(node) & ~pointer_mask)
+            std::abort();
+        std::uint64_t old_head = head.load(std::memory_order_relaxed);
+        do
+        {
+            node->next.store(pointer_of(old_head), std::memory_order_relaxed);
+        }
+        while (!head.compare_exchange_weak(old_head, next_word(old_head, node), std::memory_order_release,
+                                           std::memory_order_relaxed));
+    }
+
+    /**
+     * @return The former top node, which now belongs to the caller, or nullptr if the list is empty.
+     */
+    Node* pop()
+    {
+        std::uint64_t old_head = head.load(std::memory_order_acquire);
+        while (Node* node = pointer_of(old_head))
+        {
+            // node may be popped and recycled concurrently, then the value read here is stale and the tag makes the CAS fail
+            Node* next = node->next.load(std::memory_order_relaxed);
+            if (head.compare_exchange_weak(old_head, next_word(old_head, next), std::memory_order_acquire,
+                                           std::memory_order_acquire))
+                return node;
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return pointer_of(head.load(std::memory_order_acquire)) == nullptr;
+    }
+};
+
+/**
+ * @class TaggedLockFreeStack
+ * @brief Lock-free stack that avoids ABA with a tagged head instead of hazard pointers.
+ *
+ * Popped nodes are not reclaimed but kept on a free list of the stack and reused by later pushes, so memory
+ * of a node is only returned once the stack is destroyed. In exchange neither push nor pop has to publish or
+ * validate a hazard pointer. There is no top(): reading the payload of a node that is not owned by the caller
+ * would race with its reuse.
+ */
+template <typename T>
+class TaggedLockFreeStack
+{
+    struct Node
+    {
+        std::atomic<Node*> next{nullptr};
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* data()
+        {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    TaggedPointerList<Node> items;
+    TaggedPointerList<Node> free_nodes;
+
+    Node* acquire_node()
+    {
+        if (Node* node = free_nodes.pop())
+            return node;
+        return new Node;
+    }
+
+public:
+    TaggedLockFreeStack() = default;
+    TaggedLockFreeStack(const TaggedLockFreeStack&) = delete;
+    TaggedLockFreeStack& operator=(const TaggedLockFreeStack&) = delete;
+
+    ~TaggedLockFreeStack()
+    {
+        while (Node* node = items.pop())
+        {
+            std::destroy_at(node->data());
+            delete node;
+        }
+        while (Node* node = free_nodes.pop())
+            delete node;
+    }
+
+    void push(T val)
+    {
+        Node* node = acquire_node();
+        std::construct_at(reinterpret_cast<T*>(node->storage), std::move(val));
+        items.push(node);
+    }
+
+    std::optional<T> pop()
+    {
+        Node* node = items.pop();
+        if (!node)
+        {
+            return std::nullopt;
+        }
+        std::optional<T> result(std::move(*node->data()));
+        std::destroy_at(node->data());
+        free_nodes.push(node);
+        return result;
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return items.empty();
+    }
+};
+
+#endif //TAGGED_LOCK_FREE_STACK_H
@@ -0,0 +1,146 @@
+//
+// Created by andreas on 18.10.26.
+//
+// Throughput of ShardedConcurrentMap against LockFreeHashTable (integral keys only) and against a std::unordered_map
+// per shard behind a std::mutex; the lock-free map runs with symmetric and asymmetric hazard pointers. Every thread runs a mix of 90% lookups and 10% assignments on 2^16 present keys.
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "./../lock_free_hash_table.h"
+#include "./../sharded_concurrent_map.h"
+
+namespace
+{
+    constexpr size_t key_count = 1 << 16;
+    constexpr size_t shard_count = concurrent_map_default_shards;
+
+    template <typename Key, typename Value>
+    class MutexShardedMap
+    {
+        struct alignas(cache_line_size) Shard
+        {
+            std::mutex mutex;
+            std::unordered_map<Key, Value> map;
+        };
+
+        Shard shards[shard_count];
+
+        Shard& shard_of(const Key& key)
+        {
+            return shards[MixingHash<std::uint64_t>{}(std::hash<Key>{}(key)) % shard_count];
+        }
+
+    public:
+        void assign(const Key& key, const Value& value)
+        {
+            Shard& shard = shard_of(key);
+            std::lock_guard lock(shard.mutex);
+            shard.map.insert_or_assign(key, value);
+        }
+
+        std::optional<Value> lookup(const Key& key)
+        {
+            Shard& shard = shard_of(key);
+            std::lock_guard lock(shard.mutex);
+            auto it = shard.map.find(key);
+            if (it == shard.map.end())
+                return std::nullopt;
+            return it->second;
+        }
+    };
+
+    template <typename Key, typename Value, typename Reclamation = HazardPointerReclamation>
+    class LockFreeMap
+    {
+        ShardedConcurrentMap<Key, Value, std::hash<Key>, std::equal_to<Key>, Reclamation> map;
+
+    public:
+        void assign(const Key& key, const Value& value)
+        {
+            map.insert_or_assign(key, value);
+        }
+
+        std::optional<Value> lookup(const Key& key)
+        {
+            return map.lookup(key);
+        }
+    };
+
+    class FixedTable
+    {
+        LockFreeHashTable<int64_t, int64_t, -1, -1, key_count * 2> table;
+
+    public:
+        void assign(int64_t key, int64_t value)
+        {
+            table.insert(key, value);
+        }
+
+        int64_t lookup(int64_t key)
+        {
+            return table.lookup(key);
+        }
+    };
+
+    template <typename Key>
+    Key make_key(size_t index)
+    {
+        if constexpr (std::is_integral_v<Key>)
+            return static_cast<Key>(index);
+        else
+            return "user:" + std::to_string(index) + ":profile";
+    }
+
+    template <typename Map>
+    Map* shared_map = nullptr;
+}
+
+template <typename Map, typename Key, typename Value>
+static void BM_MixedWorkload(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+    {
+        shared_map<Map> = new Map;
+        for (size_t i = 0; i < key_count; ++i)
+            shared_map<Map>->assign(make_key<Key>(i), make_key<Value>(i));
+    }
+    std::vector<Key> keys(key_count);
+    for (size_t i = 0; i < key_count; ++i)
+        keys[i] = make_key<Key>(i);
+    const Value value = make_key<Value>(state.thread_index());
+    std::mt19937 generator(state.thread_index());
+    for (auto _ : state)
+    {
+        const auto random = generator();
+        const Key& key = keys[random % key_count];
+        if (random >> 28 == 0)
+            shared_map<Map>->assign(key, value);
+        else
+            benchmark::DoNotOptimize(shared_map<Map>->lookup(key));
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0)
+    {
+        delete shared_map<Map>;
+        shared_map<Map> = nullptr;
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_MixedWorkload, FixedTable, int64_t, int64_t)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MixedWorkload, LockFreeMap<int64_t, int64_t>, int64_t, int64_t)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MixedWorkload, LockFreeMap<int64_t, int64_t, AsymmetricHazardPointerReclamation>, int64_t, int64_t)
+    ->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MixedWorkload, MutexShardedMap<int64_t, int64_t>, int64_t, int64_t)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MixedWorkload, LockFreeMap<std::string, std::string>, std::string, std::string)
+    ->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MixedWorkload, MutexShardedMap<std::string, std::string>, std::string, std::string)
+    ->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,355 @@
+//
+// Created by andreas on 18.10.26.
+//
+// Probe lengths and lookup cost of LockFreeHashTable for different hashers and key distributions. Every benchmark
+// fills half of the table and reports the histogram of the probe lengths as counters:
+// probes_1, probes_2-3, probes_4-7, ... count the keys whose lookup examines that many entries.
+// The int32/int32 benchmarks compare the two-atomic entries with the packed single-word entries, the load factor
+// benchmarks linear probing of single entries with the group probing of SwissLockFreeHashTable. The churn benchmark
+// keeps a resizable table busy with inserts and erases of ever new keys. The batch benchmarks at the end compare
+// single-key lookups and inserts with lookup_batch() and insert_batch() on a table larger than the last-level cache.
+// The placement benchmarks look up random keys in such a table built with each TablePlacement, from threads pinned to
+// the NUMA nodes in turn, and report the lookups per second of the threads on every node as counters node0, node1, ...
+#include <benchmark/benchmark.h>
+#include <bit>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "./../lock_free_hash_table.h"
+#include "./../packed_lock_free_hash_table.h"
+#include "./../resizable_lock_free_hash_table.h"
+#include "./../swiss_lock_free_hash_table.h"
+
+namespace
+{
+    constexpr size_t table_size = 1 << 16;
+    constexpr size_t prime_table_size = 65521;
+    constexpr size_t key_count = table_size / 2;
+
+    enum class Keys { sequential, strided, random };
+
+    std::vector<int64_t> make_keys(Keys kind)
+    {
+        std::vector<int64_t> keys(key_count);
+        std::mt19937_64 generator(42);
+        for (size_t i = 0; i < key_count; ++i)
+        {
+            switch (kind)
+            {
+            case Keys::sequential:
+                keys[i] = static_cast<int64_t>(i);
+                break;
+            case Keys::strided:
+                // Column-major walk over a row-major DP table with 1024 columns
+                keys[i] = static_cast<int64_t>((i % 1024) * 1024 + i / 1024);
+                break;
+            case Keys::random:
+                keys[i] = static_cast<int64_t>(generator() >> 1);
+                break;
+            }
+        }
+        return keys;
+    }
+
+    template <typename Table>
+    void report_probe_histogram(benchmark::State& state, const Table& table, const std::vector<int64_t>& keys)
+    {
+        std::vector<size_t> histogram(std::bit_width(table_size) + 1);
+        size_t total{}, longest{};
+        for (auto key : keys)
+        {
+            const size_t probes = table.probe_length(key);
+            ++histogram[std::bit_width(probes) - 1];
+            total += probes;
+            longest = std::max(longest, probes);
+        }
+        for (size_t bucket = 0; bucket < histogram.size(); ++bucket)
+        {
+            if (!histogram[bucket])
+                continue;
+            const size_t low = size_t{1} << bucket;
+            const std::string name = low == 1 ? "probes_1" : "probes_" + std::to_string(low) + "-" + std::to_string(2 * low - 1);
+            state.counters[name] = static_cast<double>(histogram[bucket]);
+        }
+        state.counters["probes_mean"] = static_cast<double>(total) / static_cast<double>(keys.size());
+        state.counters["probes_max"] = static_cast<double>(longest);
+    }
+}
+
+template <size_t TableSize, typename Hasher, Keys KeyKind>
+static void BM_LockFreeHashTableLookup(benchmark::State& state)
+{
+    auto table = std::make_unique<LockFreeHashTable<int64_t, int32_t, -1, -1, TableSize, Hasher>>();
+    const auto keys = make_keys(KeyKind);
+    for (auto key : keys)
+        table->insert(key, 1);
+
+    size_t index{};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(table->lookup(keys[index]));
+        index = index + 1 == keys.size() ? 0 : index + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+    report_probe_histogram(state, *table, keys);
+}
+
+#define HASH_TABLE_BENCHMARKS(KeyKind) \
+    BENCHMARK_TEMPLATE(BM_LockFreeHashTableLookup, prime_table_size, IdentityHash<int64_t>, KeyKind); \
+    BENCHMARK_TEMPLATE(BM_LockFreeHashTableLookup, table_size, IdentityHash<int64_t>, KeyKind); \
+    BENCHMARK_TEMPLATE(BM_LockFreeHashTableLookup, prime_table_size, MixingHash<int64_t>, KeyKind); \
+    BENCHMARK_TEMPLATE(BM_LockFreeHashTableLookup, table_size, MixingHash<int64_t>, KeyKind)
+
+HASH_TABLE_BENCHMARKS(Keys::sequential);
+HASH_TABLE_BENCHMARKS(Keys::strided);
+HASH_TABLE_BENCHMARKS(Keys::random);
+
+// Random lookups and inserts of int32 keys and values; the table holds 2^22 entries, half of them used.
+// Both entry layouts take 8 bytes, the packed one is read and written with one access.
+namespace
+{
+    constexpr int32_t int32_table_size = 1 << 22;
+    constexpr int32_t int32_key_count = int32_table_size / 2;
+    using TwoAtomicTable = LockFreeHashTable<int32_t, int32_t, -1, -1, int32_table_size>;
+    using PackedTable = PackedLockFreeHashTable<int32_t, int32_t, -1, -1, int32_table_size>;
+    template <typename Table>
+    Table* int32_table = nullptr;
+}
+
+template <typename Table>
+static void BM_Int32HashTableLookup(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+    {
+        int32_table<Table> = new Table;
+        for (int32_t key = 0; key < int32_key_count; ++key)
+            int32_table<Table>->insert(key, key);
+    }
+    std::mt19937 generator(state.thread_index());
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(int32_table<Table>->lookup(static_cast<int32_t>(generator() % int32_key_count)));
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0)
+    {
+        delete int32_table<Table>;
+        int32_table<Table> = nullptr;
+    }
+}
+
+template <typename Table>
+static void BM_Int32HashTableInsert(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+        int32_table<Table> = new Table;
+    std::mt19937 generator(state.thread_index());
+    for (auto _ : state)
+    {
+        const auto key = static_cast<int32_t>(generator() % int32_key_count);
+        benchmark::DoNotOptimize(int32_table<Table>->insert(key, key));
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0)
+    {
+        delete int32_table<Table>;
+        int32_table<Table> = nullptr;
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_Int32HashTableLookup, TwoAtomicTable)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Int32HashTableLookup, PackedTable)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Int32HashTableInsert, TwoAtomicTable)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Int32HashTableInsert, PackedTable)->ThreadRange(1, 8)->UseRealTime();
+
+// Lookups of present and absent keys at a load factor of range(0) percent; the table holds 2^20 entries.
+namespace
+{
+    constexpr size_t load_table_size = 1 << 20;
+    using LinearTable = LockFreeHashTable<int64_t, int32_t, -1, -1, load_table_size>;
+    using SwissTable = SwissLockFreeHashTable<int64_t, int32_t, -1, -1, load_table_size>;
+}
+
+template <typename Table, bool Present>
+static void BM_LoadFactorLookup(benchmark::State& state)
+{
+    auto table = std::make_unique<Table>();
+    const auto used = static_cast<int64_t>(load_table_size * static_cast<size_t>(state.range(0)) / 100);
+    for (int64_t key = 0; key < used; ++key)
+        table->insert(key, 1);
+
+    // Absent keys are taken from above the inserted range
+    std::mt19937_64 generator(42);
+    std::vector<int64_t> keys(1 << 16);
+    for (auto& key : keys)
+        key = static_cast<int64_t>(generator() % static_cast<uint64_t>(used)) + (Present ? 0 : used);
+
+    size_t index{};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(table->lookup(keys[index]));
+        index = (index + 1) & (keys.size() - 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_LoadFactorLookup, LinearTable, true)->Arg(50)->Arg(75)->Arg(87)->Arg(95);
+BENCHMARK_TEMPLATE(BM_LoadFactorLookup, SwissTable, true)->Arg(50)->Arg(75)->Arg(87)->Arg(95);
+BENCHMARK_TEMPLATE(BM_LoadFactorLookup, LinearTable, false)->Arg(50)->Arg(75)->Arg(87)->Arg(95);
+BENCHMARK_TEMPLATE(BM_LoadFactorLookup, SwissTable, false)->Arg(50)->Arg(75)->Arg(87)->Arg(95);
+
+// Sliding window of range(0) live keys: every iteration inserts a new key and erases the oldest one. Tombstones are
+// dropped by compacting migrations, so the capacity and the cost per operation stay flat however long it runs.
+static void BM_ResizableChurn(benchmark::State& state)
+{
+    const auto window = static_cast<int64_t>(state.range(0));
+    ResizableLockFreeHashTable<int64_t, int32_t, -1, -1, -2> table(static_cast<size_t>(window) * 4);
+    int64_t key{};
+    for (auto _ : state)
+    {
+        table.insert(key, 1);
+        if (key >= window)
+            table.erase(key - window);
+        benchmark::DoNotOptimize(table.lookup(key - window / 2));
+        ++key;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["capacity"] = static_cast<double>(table.capacity());
+}
+
+BENCHMARK(BM_ResizableChurn)->Arg(1 << 10)->Arg(1 << 16);
+
+// 2^24 entries of 16 bytes, i.e. 256 MiB, half of them used; every iteration handles batch_size random keys.
+namespace
+{
+    constexpr size_t large_table_size = 1 << 24;
+    constexpr size_t large_key_count = large_table_size / 2;
+    constexpr size_t batch_size = 1024;
+    using LargeTable = LockFreeHashTable<int64_t, int32_t, -1, -1, large_table_size>;
+
+    std::unique_ptr<LargeTable>& large_table()
+    {
+        static std::unique_ptr<LargeTable> table = []()
+        {
+            auto filled = std::make_unique<LargeTable>();
+            for (size_t key = 0; key < large_key_count; ++key)
+                filled->insert(static_cast<int64_t>(key), 1);
+            return filled;
+        }();
+        return table;
+    }
+
+    std::vector<int64_t> random_batch(std::mt19937_64& generator, uint64_t key_range)
+    {
+        std::vector<int64_t> keys(batch_size);
+        for (auto& key : keys)
+            key = static_cast<int64_t>(generator() % key_range);
+        return keys;
+    }
+}
+
+template <bool Batched>
+static void BM_LargeTableLookup(benchmark::State& state)
+{
+    const auto& table = large_table();
+    std::mt19937_64 generator(42);
+    std::vector<int32_t> values(batch_size);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        const auto keys = random_batch(generator, large_key_count);
+        state.ResumeTiming();
+        if constexpr (Batched)
+        {
+            table->lookup_batch(keys, values);
+        }
+        else
+        {
+            for (size_t i = 0; i < batch_size; ++i)
+                values[i] = table->lookup(keys[i]);
+        }
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * batch_size));
+}
+
+// Inserts overwrite present keys, so the table does not fill up however long the benchmark runs
+template <bool Batched>
+static void BM_LargeTableInsert(benchmark::State& state)
+{
+    const auto& table = large_table();
+    std::mt19937_64 generator(43);
+    const std::vector<int32_t> values(batch_size, 2);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        const auto keys = random_batch(generator, large_key_count);
+        state.ResumeTiming();
+        if constexpr (Batched)
+        {
+            benchmark::DoNotOptimize(table->insert_batch(keys, values));
+        }
+        else
+        {
+            for (size_t i = 0; i < batch_size; ++i)
+                benchmark::DoNotOptimize(table->insert(keys[i], values[i]));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * batch_size));
+}
+
+BENCHMARK_TEMPLATE(BM_LargeTableLookup, false);
+BENCHMARK_TEMPLATE(BM_LargeTableLookup, true);
+BENCHMARK_TEMPLATE(BM_LargeTableInsert, false);
+BENCHMARK_TEMPLATE(BM_LargeTableInsert, true);
+
+// The table of the current run, built before the threads start
+namespace
+{
+    std::unique_ptr<LargeTable> placed_table;
+
+    void build_placed_table(const benchmark::State& state)
+    {
+        placed_table = std::make_unique<LargeTable>(static_cast<TablePlacement>(state.range(0)));
+        for (size_t key = 0; key < large_key_count; ++key)
+            placed_table->insert(static_cast<int64_t>(key), 1);
+    }
+
+    void release_placed_table(const benchmark::State&)
+    {
+        placed_table.reset();
+    }
+}
+
+static void BM_PlacedTableLookup(benchmark::State& state)
+{
+    const size_t node = static_cast<size_t>(state.thread_index()) % numa_node_count();
+    pin_to_numa_node(node);
+    std::mt19937_64 generator(42 + state.thread_index());
+    std::vector<int32_t> values(batch_size);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        const auto keys = random_batch(generator, large_key_count);
+        state.ResumeTiming();
+        for (size_t i = 0; i < batch_size; ++i)
+            values[i] = placed_table->lookup(keys[i]);
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * batch_size));
+    state.counters["node" + std::to_string(node)] =
+        benchmark::Counter(static_cast<double>(state.iterations() * batch_size), benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_PlacedTableLookup)
+    ->Setup(build_placed_table)->Teardown(release_placed_table)
+    ->ArgName("placement")
+    ->Arg(static_cast<int64_t>(TablePlacement::single_thread))
+    ->Arg(static_cast<int64_t>(TablePlacement::first_touch))
+    ->Arg(static_cast<int64_t>(TablePlacement::interleave))
+    ->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,217 @@
+//
+// Created by andreas on 18.10.26.
+//
+// Memory footprint and lookup throughput of LockFreeSkipList with 10M keys inserted in random order. The counters
+// report the resident memory the list occupies per key (measured around building it) and the lookups per second of
+// random keys, half of which are present.
+// The mixed benchmarks run 90% searches, 9% inserts and 1% removes of random keys on a shared list of 2^16 keys with
+// each reclamation policy, so the cost of protecting the traversal shows up in the search path.
+// The level benchmarks compare drawing node levels from one std::mt19937 with a std::bernoulli_distribution, as the
+// list did before, with SkipListLevels on the thread-local xorshift generator.
+// The insertion pattern benchmarks fill an empty list with 2^18 keys that arrive almost sorted (ascending with a small
+// jitter) or in random order, with and without a Finger.
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <vector>
+#include <unistd.h>
+#include "./../epoch_reclamation.h"
+#include "./../lock_free_skip_list.h"
+
+namespace
+{
+    constexpr size_t skip_list_key_count = 10'000'000;
+    // About log2 of the key count, so the upper levels still thin out
+    constexpr int skip_list_max_level = 24;
+    using SkipList = LockFreeSkipList<int64_t, int64_t, skip_list_max_level>;
+
+    size_t resident_bytes()
+    {
+        std::ifstream statm("/proc/self/statm");
+        size_t total_pages{}, resident_pages{};
+        statm >> total_pages >> resident_pages;
+        return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    struct FilledSkipList
+    {
+        std::unique_ptr<SkipList> list;
+        double bytes_per_key{};
+    };
+
+    // The even keys below 2 * skip_list_key_count
+    FilledSkipList& filled_skip_list()
+    {
+        static FilledSkipList filled = []()
+        {
+            std::vector<int64_t> keys(skip_list_key_count);
+            for (size_t i = 0; i < skip_list_key_count; ++i)
+                keys[i] = static_cast<int64_t>(2 * i);
+            std::shuffle(keys.begin(), keys.end(), std::mt19937_64(42));
+            FilledSkipList result;
+            const size_t before = resident_bytes();
+            result.list = std::make_unique<SkipList>();
+            for (int64_t key : keys)
+                result.list->insert(key, key);
+            result.bytes_per_key = static_cast<double>(resident_bytes() - before) / skip_list_key_count;
+            return result;
+        }();
+        return filled;
+    }
+}
+
+static void BM_SkipListLookup(benchmark::State& state)
+{
+    auto& filled = filled_skip_list();
+    std::mt19937_64 generator(43);
+    int64_t value{};
+    for (auto _ : state)
+    {
+        const auto key = static_cast<int64_t>(generator() % (2 * skip_list_key_count));
+        benchmark::DoNotOptimize(filled.list->search(key, value));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes_per_key"] = filled.bytes_per_key;
+}
+
+BENCHMARK(BM_SkipListLookup);
+
+// The list of the current run, built before the threads start
+namespace
+{
+    constexpr int64_t mixed_key_range = 1 << 17;
+
+    template <typename Reclamation>
+    std::unique_ptr<LockFreeSkipList<int64_t, int64_t, 16, Reclamation>> mixed_list;
+
+    template <typename Reclamation>
+    void build_mixed_list(const benchmark::State&)
+    {
+        mixed_list<Reclamation> = std::make_unique<LockFreeSkipList<int64_t, int64_t, 16, Reclamation>>();
+        for (int64_t key = 0; key < mixed_key_range; key += 2)
+            mixed_list<Reclamation>->insert(key, key);
+    }
+
+    template <typename Reclamation>
+    void release_mixed_list(const benchmark::State&)
+    {
+        mixed_list<Reclamation>.reset();
+    }
+}
+
+template <typename Reclamation>
+static void BM_SkipListMixed(benchmark::State& state)
+{
+    auto& list = *mixed_list<Reclamation>;
+    std::mt19937_64 generator(44 + state.thread_index());
+    int64_t value{};
+    for (auto _ : state)
+    {
+        const uint64_t random = generator();
+        const auto key = static_cast<int64_t>((random >> 8) % mixed_key_range);
+        const uint64_t operation = (random & 0xff) % 100;
+        if (operation < 90)
+            benchmark::DoNotOptimize(list.search(key, value));
+        else if (operation < 99)
+            benchmark::DoNotOptimize(list.insert(key, key));
+        else
+            benchmark::DoNotOptimize(list.remove(key));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_SkipListMixed, HazardPointerReclamation)
+    ->Setup(build_mixed_list<HazardPointerReclamation>)->Teardown(release_mixed_list<HazardPointerReclamation>)
+    ->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_SkipListMixed, AsymmetricHazardPointerReclamation)
+    ->Setup(build_mixed_list<AsymmetricHazardPointerReclamation>)
+    ->Teardown(release_mixed_list<AsymmetricHazardPointerReclamation>)
+    ->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_SkipListMixed, EpochReclamation)
+    ->Setup(build_mixed_list<EpochReclamation>)->Teardown(release_mixed_list<EpochReclamation>)
+    ->ThreadRange(1, 8)->UseRealTime();
+
+// The former level generator of the list. Shared by all threads of a list it is a data race, so it runs single-threaded.
+namespace
+{
+    class MersenneTwisterLevels
+    {
+        std::mt19937 generator{std::random_device{}()};
+        std::bernoulli_distribution distribution;
+
+    public:
+        explicit MersenneTwisterLevels(float probability) : distribution(probability)
+        {
+        }
+
+        int operator()()
+        {
+            int level{};
+            while (level < 16 && distribution(generator))
+                level++;
+            return level;
+        }
+    };
+}
+
+template <typename Levels>
+static void BM_SkipListLevel(benchmark::State& state)
+{
+    Levels levels(static_cast<float>(state.range(0)) / 100);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(levels());
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_SkipListLevel, MersenneTwisterLevels)->ArgName("percent")->Arg(50)->Arg(30);
+BENCHMARK_TEMPLATE(BM_SkipListLevel, SkipListLevels<16>)->ArgName("percent")->Arg(50)->Arg(30)->ThreadRange(1, 8);
+
+namespace
+{
+    constexpr size_t pattern_key_count = 1 << 18;
+
+    enum class Arrival { almost_sorted, random };
+
+    std::vector<int64_t> arriving_keys(Arrival arrival)
+    {
+        std::vector<int64_t> keys(pattern_key_count);
+        std::mt19937_64 generator(45);
+        for (size_t i = 0; i < pattern_key_count; ++i)
+        {
+            keys[i] = static_cast<int64_t>(8 * i + generator() % 32);
+        }
+        if (arrival == Arrival::random)
+            std::shuffle(keys.begin(), keys.end(), generator);
+        return keys;
+    }
+}
+
+template <Arrival KeyArrival, bool UseFinger>
+static void BM_SkipListInsertPattern(benchmark::State& state)
+{
+    using PatternList = LockFreeSkipList<int64_t, int64_t, 20>;
+    const auto keys = arriving_keys(KeyArrival);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto list = std::make_unique<PatternList>();
+        state.ResumeTiming();
+        PatternList::Finger finger;
+        for (int64_t key : keys)
+            benchmark::DoNotOptimize(list->insert(key, key, UseFinger ? &finger : nullptr));
+        state.PauseTiming();
+        list.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * pattern_key_count));
+}
+
+BENCHMARK_TEMPLATE(BM_SkipListInsertPattern, Arrival::almost_sorted, false);
+BENCHMARK_TEMPLATE(BM_SkipListInsertPattern, Arrival::almost_sorted, true);
+BENCHMARK_TEMPLATE(BM_SkipListInsertPattern, Arrival::random, false);
+BENCHMARK_TEMPLATE(BM_SkipListInsertPattern, Arrival::random, true);
+
+BENCHMARK_MAIN();
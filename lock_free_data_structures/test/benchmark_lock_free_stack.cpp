@@ -0,0 +1,177 @@
+//
+// Created by andreas on 18.10.26.
+//
+// Throughput of LockFreeStack vs. number of threads. This file is built twice: once with the default
+// cache-line padded hazard pointer records and once with HAZARD_POINTER_PACKED_RECORDS, so that the
+// effect of the padding can be compared on the machine at hand:
+//   ./benchmark_lock_free_stack_packed && ./benchmark_lock_free_stack
+// Each benchmark runs with the symmetric and the asymmetric (membarrier) hazard pointer publish path;
+// pop/push additionally runs with the elimination backoff array, the node pool allocator and the tagged-pointer stack.
+#include <benchmark/benchmark.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "./../epoch_reclamation.h"
+#include "./../lock_free_stack.h"
+#include "./../pool_allocator.h"
+#include "./../tagged_lock_free_stack.h"
+
+namespace
+{
+    constexpr int prefilled_items = 1 << 16;
+    template <typename Stack>
+    Stack* shared_stack = nullptr;
+
+    template <typename Stack>
+    void set_up_shared_stack(const benchmark::State& state)
+    {
+        if (state.thread_index() == 0)
+        {
+            shared_stack<Stack> = new Stack;
+            for (int i = 0; i < prefilled_items; ++i)
+                shared_stack<Stack>->push(i);
+        }
+    }
+
+    template <typename Stack>
+    void tear_down_shared_stack(benchmark::State& state)
+    {
+        if (state.thread_index() == 0)
+        {
+            delete shared_stack<Stack>;
+            shared_stack<Stack> = nullptr;
+        }
+        state.SetItemsProcessed(state.iterations());
+        state.SetLabel(hazard_pointer_record_alignment == cache_line_size ? "padded records" : "packed records");
+    }
+}
+
+// Every iteration pops one item and pushes it back, so the stack never runs empty.
+template <typename Stack>
+static void BM_LockFreeStackPopPush(benchmark::State& state)
+{
+    set_up_shared_stack<Stack>(state);
+    for (auto _ : state)
+    {
+        auto value = shared_stack<Stack>->pop();
+        benchmark::DoNotOptimize(value);
+        shared_stack<Stack>->push(value.value_or(0));
+    }
+    tear_down_shared_stack<Stack>(state);
+}
+
+// A batch of items is pushed and drained again, once item by item and once with the bulk operations.
+static void BM_LockFreeStackBatchSingle(benchmark::State& state)
+{
+    set_up_shared_stack<LockFreeStack<int>>(state);
+    const auto batch_size = static_cast<int>(state.range(0));
+    for (auto _ : state)
+    {
+        for (int i = 0; i < batch_size; ++i)
+            shared_stack<LockFreeStack<int>>->push(i);
+        for (int i = 0; i < batch_size; ++i)
+            benchmark::DoNotOptimize(shared_stack<LockFreeStack<int>>->pop());
+    }
+    tear_down_shared_stack<LockFreeStack<int>>(state);
+    state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+static void BM_LockFreeStackBatchBulk(benchmark::State& state)
+{
+    set_up_shared_stack<LockFreeStack<int>>(state);
+    std::vector<int> batch(state.range(0));
+    for (auto _ : state)
+    {
+        shared_stack<LockFreeStack<int>>->push_range(batch.begin(), batch.end());
+        benchmark::DoNotOptimize(shared_stack<LockFreeStack<int>>->pop_n(batch.size()));
+    }
+    tear_down_shared_stack<LockFreeStack<int>>(state);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Round trip of a string that does not fit into the small string buffer. Pushing an lvalue copies it, i.e. allocates;
+// pushing an rvalue or emplacing only moves the heap buffer. pop() moves the value out in all cases.
+enum class PushKind { copy, move, emplace };
+
+template <PushKind Kind>
+static void BM_LockFreeStackStringRoundTrip(benchmark::State& state)
+{
+    LockFreeStack<std::string> stack;
+    std::string value(64, 'x');
+    for (auto _ : state)
+    {
+        if constexpr (Kind == PushKind::copy)
+            stack.push(value);
+        else if constexpr (Kind == PushKind::move)
+            stack.push(std::move(value));
+        else
+            stack.emplace(std::move(value));
+        value = std::move(*stack.pop());
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Read-only traffic: top() only publishes and clears the calling thread's hazard pointer.
+template <typename Stack>
+static void BM_LockFreeStackTop(benchmark::State& state)
+{
+    set_up_shared_stack<Stack>(state);
+    for (auto _ : state)
+    {
+        auto value = shared_stack<Stack>->top();
+        benchmark::DoNotOptimize(value);
+    }
+    tear_down_shared_stack<Stack>(state);
+}
+
+// Read-mostly traffic on strings: 15 of 16 operations are top(), the others pop an item and push it back. With a T that
+// is not trivially copyable, pops have to find out whether a top() may still be copying the node they unlinked.
+template <typename Reclamation>
+static void BM_LockFreeStackTopHeavy(benchmark::State& state)
+{
+    using Stack = LockFreeStack<std::string, Reclamation>;
+    if (state.thread_index() == 0)
+    {
+        shared_stack<Stack> = new Stack;
+        for (int i = 0; i < prefilled_items; ++i)
+            shared_stack<Stack>->emplace(64, 'x');
+    }
+    unsigned operation = 0;
+    for (auto _ : state)
+    {
+        if (++operation % 16 != 0)
+        {
+            auto value = shared_stack<Stack>->top();
+            benchmark::DoNotOptimize(value);
+        }
+        else if (auto value = shared_stack<Stack>->pop())
+        {
+            shared_stack<Stack>->push(std::move(*value));
+        }
+    }
+    tear_down_shared_stack<Stack>(state);
+}
+
+using HazardPointerStack = LockFreeStack<int, HazardPointerReclamation>;
+using AsymmetricHazardPointerStack = LockFreeStack<int, AsymmetricHazardPointerReclamation>;
+using EliminationStack = LockFreeStack<int, HazardPointerReclamation, EliminationBackoff>;
+using PoolStack = LockFreeStack<int, HazardPointerReclamation, NoBackoff, PoolAllocator<int>>;
+
+BENCHMARK_TEMPLATE(BM_LockFreeStackPopPush, HazardPointerStack)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LockFreeStackPopPush, AsymmetricHazardPointerStack)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LockFreeStackPopPush, EliminationStack)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LockFreeStackPopPush, PoolStack)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LockFreeStackPopPush, TaggedLockFreeStack<int>)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(BM_LockFreeStackBatchSingle)->Arg(256)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(BM_LockFreeStackBatchBulk)->Arg(256)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LockFreeStackStringRoundTrip, PushKind::copy);
+BENCHMARK_TEMPLATE(BM_LockFreeStackStringRoundTrip, PushKind::move);
+BENCHMARK_TEMPLATE(BM_LockFreeStackStringRoundTrip, PushKind::emplace);
+BENCHMARK_TEMPLATE(BM_LockFreeStackTop, HazardPointerStack)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LockFreeStackTop, AsymmetricHazardPointerStack)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LockFreeStackTopHeavy, HazardPointerReclamation)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LockFreeStackTopHeavy, AsymmetricHazardPointerReclamation)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LockFreeStackTopHeavy, EpochReclamation)->ThreadRange(1, 64)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,155 @@
+//
+// Created by andreas on 18.10.26.
+//
+// Longest common subsequence and 0/1 knapsack solved bottom-up on one thread, and top-down with parallel_top_down()
+// on range(0) threads sharing a LockFreeHashTable. The top-down variants include clearing a fresh memo table.
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "./../lock_free_hash_table.h"
+#include "./../parallel_top_down.h"
+
+namespace
+{
+    constexpr size_t lcs_length = 1000;
+    constexpr size_t knapsack_items = 100;
+    constexpr int32_t knapsack_capacity = 10000;
+    // Both problems have about 2^20 subproblems, the table keeps the load factor at one half
+    constexpr size_t memo_table_size = 1 << 21;
+    using MemoTable = LockFreeHashTable<int64_t, int32_t, -1, -1, memo_table_size, MixingHash<int64_t>, -2>;
+
+    std::string random_string(size_t length, unsigned seed)
+    {
+        std::mt19937 generator(seed);
+        std::string result(length, 'a');
+        for (auto& c : result)
+            c = static_cast<char>('a' + generator() % 4);
+        return result;
+    }
+
+    const std::string lcs_a = random_string(lcs_length, 1);
+    const std::string lcs_b = random_string(lcs_length, 2);
+
+    struct Knapsack
+    {
+        std::vector<int32_t> weights, values;
+
+        Knapsack() : weights(knapsack_items), values(knapsack_items)
+        {
+            std::mt19937 generator(3);
+            for (size_t item = 0; item < knapsack_items; ++item)
+            {
+                weights[item] = static_cast<int32_t>(1 + generator() % 1000);
+                values[item] = static_cast<int32_t>(1 + generator() % 1000);
+            }
+        }
+    };
+
+    const Knapsack knapsack;
+
+    // Longest common subsequence of the prefixes a[0, i) and b[0, j), keyed by i * (b.size() + 1) + j
+    struct LcsSolver
+    {
+        template <typename Context>
+        int32_t operator()(int64_t key, Context& context) const
+        {
+            constexpr auto columns = static_cast<int64_t>(lcs_length + 1);
+            const int64_t i = key / columns, j = key % columns;
+            if (i == 0 || j == 0)
+                return 0;
+            if (lcs_a[i - 1] == lcs_b[j - 1])
+                return context(key - columns - 1) + 1;
+            context.spawn(key - 1);
+            const int32_t up = context(key - columns);
+            return std::max(up, context(key - 1));
+        }
+    };
+
+    // Best value of the first i items within weight w, keyed by i * (capacity + 1) + w
+    struct KnapsackSolver
+    {
+        template <typename Context>
+        int32_t operator()(int64_t key, Context& context) const
+        {
+            constexpr int64_t columns = knapsack_capacity + 1;
+            const int64_t i = key / columns, w = key % columns;
+            if (i == 0)
+                return 0;
+            const int64_t skip = key - columns;
+            if (knapsack.weights[i - 1] > w)
+                return context(skip);
+            context.spawn(skip);
+            const int32_t take = context(skip - knapsack.weights[i - 1]) + knapsack.values[i - 1];
+            return std::max(take, context(skip));
+        }
+    };
+
+    template <typename Solver>
+    void run_top_down(benchmark::State& state, int64_t root)
+    {
+        const auto threads = static_cast<size_t>(state.range(0));
+        int32_t result{};
+        for (auto _ : state)
+        {
+            auto table = std::make_unique<MemoTable>();
+            result = parallel_top_down(*table, root, Solver{}, threads);
+            benchmark::DoNotOptimize(result);
+        }
+        state.counters["result"] = result;
+    }
+}
+
+static void BM_LcsSerialBottomUp(benchmark::State& state)
+{
+    int32_t result{};
+    for (auto _ : state)
+    {
+        std::vector<int32_t> previous(lcs_length + 1, 0), row(lcs_length + 1, 0);
+        for (size_t i = 1; i <= lcs_length; ++i)
+        {
+            for (size_t j = 1; j <= lcs_length; ++j)
+                row[j] = lcs_a[i - 1] == lcs_b[j - 1] ? previous[j - 1] + 1 : std::max(previous[j], row[j - 1]);
+            std::swap(previous, row);
+        }
+        result = previous[lcs_length];
+        benchmark::DoNotOptimize(result);
+    }
+    state.counters["result"] = result;
+}
+
+static void BM_LcsParallelTopDown(benchmark::State& state)
+{
+    run_top_down<LcsSolver>(state, static_cast<int64_t>(lcs_length * (lcs_length + 1) + lcs_length));
+}
+
+static void BM_KnapsackSerialBottomUp(benchmark::State& state)
+{
+    int32_t result{};
+    for (auto _ : state)
+    {
+        std::vector<int32_t> best(knapsack_capacity + 1, 0);
+        for (size_t item = 0; item < knapsack_items; ++item)
+            for (int32_t w = knapsack_capacity; w >= knapsack.weights[item]; --w)
+                best[w] = std::max(best[w], best[w - knapsack.weights[item]] + knapsack.values[item]);
+        result = best[knapsack_capacity];
+        benchmark::DoNotOptimize(result);
+    }
+    state.counters["result"] = result;
+}
+
+static void BM_KnapsackParallelTopDown(benchmark::State& state)
+{
+    run_top_down<KnapsackSolver>(state, static_cast<int64_t>(knapsack_items) * (knapsack_capacity + 1) +
+                                 knapsack_capacity);
+}
+
+BENCHMARK(BM_LcsSerialBottomUp)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LcsParallelTopDown)->RangeMultiplier(2)->Range(1, 8)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_KnapsackSerialBottomUp)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_KnapsackParallelTopDown)->RangeMultiplier(2)->Range(1, 8)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
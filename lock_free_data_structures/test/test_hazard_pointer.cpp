@@ -0,0 +1,75 @@
+//
+// Created by andreas on 18.10.26.
+//
+#include "./../hazard_pointer.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::vector<void*> published_hazard_pointers()
+    {
+        std::vector<void*> pointers;
+        hazard_pointer_domain.for_each_hazard_pointer([&pointers](void* pointer) { pointers.push_back(pointer); });
+        return pointers;
+    }
+}
+
+TEST(HazardPointerTest, SlotsOfOneThreadAreIndependent)
+{
+    int first{}, second{};
+    get_hazard_pointer(0).store(&first);
+    get_hazard_pointer(1).store(&second);
+
+    auto pointers = published_hazard_pointers();
+    EXPECT_NE(std::ranges::find(pointers, &first), pointers.end());
+    EXPECT_NE(std::ranges::find(pointers, &second), pointers.end());
+
+    get_hazard_pointer(0).store(nullptr);
+    pointers = published_hazard_pointers();
+    EXPECT_EQ(std::ranges::find(pointers, &first), pointers.end());
+    EXPECT_NE(std::ranges::find(pointers, &second), pointers.end());
+    get_hazard_pointer(1).store(nullptr);
+}
+
+TEST(HazardPointerTest, MoreThreadsThanFormerFixedPool)
+{
+    constexpr int thread_count = 128;
+    std::vector<int> values(thread_count);
+    std::atomic<int> published{0};
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < thread_count; ++thread)
+    {
+        threads.emplace_back([&, thread]
+        {
+            get_hazard_pointer().store(&values[thread]);
+            published.fetch_add(1);
+            while (!done.load())
+                std::this_thread::yield();
+        });
+    }
+    while (published.load() < thread_count)
+        std::this_thread::yield();
+
+    auto pointers = published_hazard_pointers();
+    for (auto& value : values)
+    {
+        EXPECT_NE(std::ranges::find(pointers, &value), pointers.end());
+    }
+    EXPECT_GE(hazard_pointer_domain.active_slots(), thread_count * hazard_pointer_slots);
+
+    done.store(true);
+    for (auto& thread : threads)
+        thread.join();
+
+    // Exited threads cleared and released their records
+    pointers = published_hazard_pointers();
+    for (auto& value : values)
+    {
+        EXPECT_EQ(std::ranges::find(pointers, &value), pointers.end());
+    }
+}
@@ -1,8 +1,12 @@
 //
 // Created by andreas on 26.04.25.
 //
+#include <algorithm>
+#include <chrono>
 #include <random>
+#include <stdexcept>
 #include <thread>
+#include <vector>
 
 #include "./../lock_free_hash_table.h"
 #include "gtest/gtest.h"
@@ -206,3 +210,240 @@ TEST(LockFreeHashTableTest, ConcurrentInsertsAndLookups) {
     }
 }
 
+
+TEST(LockFreeHashTableTest, NonPowerOfTwoTableSize)
+{
+    LockFreeHashTable<int64_t, int32_t, -1, -1, 1000> table;
+    for (int i = 0; i < 1000; ++i)
+    {
+        EXPECT_TRUE(table.insert(i, i * 10));
+    }
+    EXPECT_FALSE(table.insert(1000, 1));
+    for (int i = 0; i < 1000; ++i)
+    {
+        EXPECT_EQ(table.lookup(i), i * 10);
+    }
+}
+
+TEST(LockFreeHashTableTest, MixingHashBreaksUpStridedKeys)
+{
+    // Keys sharing their low bits, e.g. the first column of a row-major DP table with 1024 columns
+    LockFreeHashTable<int64_t, int32_t, -1, -1, 1024, IdentityHash<int64_t>> identity_table;
+    HashTable mixing_table;
+    size_t identity_probes{}, mixing_probes{};
+    for (int row = 0; row < 256; ++row)
+    {
+        identity_table.insert(row * 1024, row);
+        mixing_table.insert(row * 1024, row);
+    }
+    for (int row = 0; row < 256; ++row)
+    {
+        EXPECT_EQ(mixing_table.lookup(row * 1024), row);
+        identity_probes += identity_table.probe_length(row * 1024);
+        mixing_probes += mixing_table.probe_length(row * 1024);
+    }
+    // The identity puts all keys into one probe run: 1 + 2 + ... + 256 probes
+    EXPECT_EQ(identity_probes, 256u * 257u / 2u);
+    EXPECT_LT(mixing_probes, 2u * 256u);
+}
+
+TEST(LockFreeHashTableTest, EraseLeavesTombstoneForSameKey)
+{
+    LockFreeHashTable<int64_t, int32_t, -1, -1, 4> table;
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_TRUE(table.insert(i, i * 10));
+    }
+    EXPECT_TRUE(table.erase(2));
+    EXPECT_FALSE(table.erase(2));
+    EXPECT_FALSE(table.erase(7));
+    EXPECT_EQ(table.lookup(2), HashTable::no_value);
+    EXPECT_EQ(table.lookup(3), 30);
+    // The tombstone is reserved for key 2, the table is still full for other keys
+    EXPECT_FALSE(table.insert(7, 70));
+    EXPECT_TRUE(table.insert(2, 21));
+    EXPECT_EQ(table.lookup(2), 21);
+}
+
+TEST(LockFreeHashTableTest, CompactReclaimsTombstonesOfDistinctKeys)
+{
+    LockFreeHashTable<int64_t, int32_t, -1, -1, 64> table;
+    int compactions = 0;
+    // Far more distinct keys than entries, but never more than 8 of them alive
+    for (int key = 0; key < 1000; ++key)
+    {
+        if (!table.insert(key, key % 100))
+        {
+            EXPECT_EQ(table.compact(), 8u);
+            ++compactions;
+            EXPECT_TRUE(table.insert(key, key % 100));
+        }
+        if (key >= 8)
+        {
+            EXPECT_TRUE(table.erase(key - 8));
+        }
+    }
+    EXPECT_GT(compactions, 0);
+    for (int key = 0; key < 1000; ++key)
+    {
+        EXPECT_EQ(table.lookup(key), key >= 992 ? key % 100 : -1);
+    }
+    // All other entries are free again
+    EXPECT_EQ(table.compact(), 8u);
+    for (int key = 1000; key < 1056; ++key)
+    {
+        EXPECT_TRUE(table.insert(key, 1));
+    }
+    EXPECT_FALSE(table.insert(1056, 1));
+}
+
+TEST(LockFreeHashTableTest, GetOrComputeRunsComputeOncePerKey)
+{
+    constexpr int num_threads = 8;
+    constexpr int key_count = 512;
+    LockFreeHashTable<int64_t, int32_t, -1, -1, 1024, MixingHash<int64_t>, -2> table;
+    std::vector<std::atomic<int>> computed(key_count);
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < num_threads; ++thread)
+    {
+        threads.emplace_back([&table, &computed, thread]()
+        {
+            for (int i = 0; i < key_count; ++i)
+            {
+                const int key = (i * 7 + thread) % key_count;
+                const int32_t value = table.get_or_compute(key, [&computed](int64_t k)
+                {
+                    computed[k].fetch_add(1);
+                    std::this_thread::yield();
+                    return static_cast<int32_t>(k * 3);
+                });
+                EXPECT_EQ(value, key * 3);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (int key = 0; key < key_count; ++key)
+    {
+        EXPECT_EQ(computed[key].load(), 1);
+        EXPECT_EQ(table.lookup(key), key * 3);
+    }
+}
+
+TEST(LockFreeHashTableTest, GetOrComputeReleasesKeyIfComputeThrows)
+{
+    LockFreeHashTable<int64_t, int32_t, -1, -1, 16, MixingHash<int64_t>, -2> table;
+    EXPECT_THROW(table.get_or_compute(5, [](int64_t) -> int32_t { throw std::runtime_error("failed"); }),
+                 std::runtime_error);
+    EXPECT_EQ(table.lookup(5), -1);
+    EXPECT_EQ(table.get_or_compute(5, [](int64_t k) { return static_cast<int32_t>(k); }), 5);
+    EXPECT_EQ(table.get_or_compute(5, [](int64_t) { return 100; }), 5);
+}
+
+TEST(LockFreeHashTableTest, EraseKeepsValueThatIsBeingComputed)
+{
+    LockFreeHashTable<int64_t, int32_t, -1, -1, 16, MixingHash<int64_t>, -2> table;
+    std::atomic<bool> computing{false};
+    std::atomic<bool> release{false};
+    std::atomic<int> computed_again{0};
+
+    std::thread computer([&]()
+    {
+        EXPECT_EQ(table.get_or_compute(7, [&](int64_t)
+        {
+            computing.store(true);
+            while (!release.load())
+                std::this_thread::yield();
+            return 70;
+        }), 70);
+    });
+    while (!computing.load())
+        std::this_thread::yield();
+    // The erase must neither report nor drop the value in flight, or the waiter below would compute it again
+    EXPECT_FALSE(table.erase(7));
+    std::thread waiter([&]()
+    {
+        EXPECT_EQ(table.get_or_compute(7, [&](int64_t)
+        {
+            computed_again.fetch_add(1);
+            return 71;
+        }), 70);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    release.store(true);
+    computer.join();
+    waiter.join();
+
+    EXPECT_EQ(computed_again.load(), 0);
+    EXPECT_TRUE(table.erase(7));
+    EXPECT_EQ(table.lookup(7), -1);
+}
+
+TEST(LockFreeHashTableTest, BatchLookupAndInsertMatchSingleKeyOperations)
+{
+    HashTable table;
+    std::vector<int64_t> keys;
+    std::vector<int32_t> values;
+    // Not a multiple of the prefetch window, so the last window is a partial one
+    for (int i = 0; i < 700; ++i)
+    {
+        keys.push_back(i * 3);
+        values.push_back(i);
+    }
+    EXPECT_EQ(table.insert_batch(keys, values), keys.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        EXPECT_EQ(table.lookup(keys[i]), values[i]);
+    }
+
+    std::vector<int64_t> queries;
+    for (int key = 0; key < 2100; ++key)
+    {
+        queries.push_back(key);
+    }
+    std::vector<int32_t> results(queries.size());
+    table.lookup_batch(queries, results);
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        EXPECT_EQ(results[i], table.lookup(queries[i]));
+    }
+
+    // Only 324 entries are left for 1000 new keys
+    std::vector<int64_t> more_keys(1000);
+    std::vector<int32_t> more_values(1000, 1);
+    for (int i = 0; i < 1000; ++i)
+    {
+        more_keys[i] = 100000 + i;
+    }
+    EXPECT_EQ(table.insert_batch(more_keys, more_values), 1024u - 700u);
+}
+
+TEST(LockFreeHashTableTest, PlacementsBehaveAlike)
+{
+    EXPECT_EQ(parse_numa_list("0-2,5,7-8\n"), (std::vector<int>{0, 1, 2, 5, 7, 8}));
+    EXPECT_GE(numa_node_count(), 1u);
+    EXPECT_EQ(numa_node_ids().size(), numa_node_count());
+    EXPECT_TRUE(std::is_sorted(numa_node_ids().begin(), numa_node_ids().end()));
+
+    // Several pages and a partial last one, initialized by more threads than there are CPUs
+    using PlacedTable = LockFreeHashTable<int64_t, int32_t, -1, -1, 3000>;
+    for (auto placement : {TablePlacement::single_thread, TablePlacement::first_touch, TablePlacement::interleave})
+    {
+        PlacedTable table(placement, 5);
+        for (int64_t key = 0; key < 3000; ++key)
+        {
+            EXPECT_EQ(table.lookup(key), -1);
+        }
+        for (int64_t key = 0; key < 3000; ++key)
+        {
+            EXPECT_TRUE(table.insert(key, static_cast<int32_t>(key * 2)));
+        }
+        for (int64_t key = 0; key < 3000; ++key)
+        {
+            EXPECT_EQ(table.lookup(key), key * 2);
+        }
+    }
+}
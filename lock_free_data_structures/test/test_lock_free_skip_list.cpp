@@ -3,7 +3,13 @@
 //
 #include "gtest/gtest.h"
 #include "./../lock_free_skip_list.h"
+#include "./../epoch_reclamation.h"
+#include "./../pool_allocator.h"
 
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <random>
 #include <thread>
 #include <vector>
 #include <string>
@@ -43,9 +49,9 @@ TEST_F(LockFreeSkipListSingleTest, InsertSearchRemove) {
 }
 
 // Fixture for multithreaded tests
-template<size_t Threads, size_t OpsPerThread>
+template<size_t Threads, size_t OpsPerThread, typename Reclamation = HazardPointerReclamation>
 void concurrent_insert_search_remove() {
-    LockFreeSkipList<int, int, 16> skip;
+    LockFreeSkipList<int, int, 16, Reclamation> skip;
     std::vector<std::thread> threads;
 
     // Concurrent inserts
@@ -98,3 +104,299 @@ TEST(LockFreeSkipListConcurrentTest, ConcurrentInsertSearchRemove) {
     concurrent_insert_search_remove<threads, ops>();
 }
 
+
+TEST(LockFreeSkipListConcurrentTest, EpochReclamationConcurrentInsertSearchRemove) {
+    constexpr size_t threads = 4;
+    constexpr size_t ops = 1000;
+    concurrent_insert_search_remove<threads, ops, EpochReclamation>();
+}
+
+// Threads insert, remove and search the same few keys, so removed nodes are retired while others still traverse them.
+// Every successful insert and remove is counted per key; afterwards a key has to be present iff the counts differ.
+template<typename Reclamation>
+void concurrent_churn_on_shared_keys() {
+    constexpr int keys = 64;
+    constexpr size_t threads = 4;
+    constexpr int ops = 20000;
+    LockFreeSkipList<int, int, 8, Reclamation> skip;
+    std::vector<std::atomic<int>> balance(keys);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            std::mt19937 generator(static_cast<unsigned>(t));
+            for (int i = 0; i < ops; ++i) {
+                const int key = static_cast<int>(generator() % keys);
+                int value;
+                switch (generator() % 3) {
+                case 0:
+                    if (skip.insert(key, key + 1))
+                        balance[key].fetch_add(1);
+                    break;
+                case 1:
+                    if (skip.remove(key))
+                        balance[key].fetch_sub(1);
+                    break;
+                default:
+                    if (skip.search(key, value)) {
+                        EXPECT_EQ(value, key + 1);
+                    }
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    for (int key = 0; key < keys; ++key) {
+        int value;
+        ASSERT_GE(balance[key].load(), 0);
+        ASSERT_LE(balance[key].load(), 1);
+        EXPECT_EQ(skip.search(key, value), balance[key].load() == 1);
+    }
+}
+
+TEST(LockFreeSkipListConcurrentTest, ChurnOnSharedKeys) {
+    concurrent_churn_on_shared_keys<HazardPointerReclamation>();
+}
+
+TEST(LockFreeSkipListConcurrentTest, EpochReclamationChurnOnSharedKeys) {
+    concurrent_churn_on_shared_keys<EpochReclamation>();
+}
+
+TEST(LockFreeSkipListConcurrentTest, AsymmetricHazardPointerChurnOnSharedKeys) {
+    concurrent_churn_on_shared_keys<AsymmetricHazardPointerReclamation>();
+}
+
+TEST_F(LockFreeSkipListSingleTest, ExtremeKeys) {
+    std::string value;
+    const int lowest = std::numeric_limits<int>::lowest();
+    const int highest = std::numeric_limits<int>::max();
+    EXPECT_FALSE(skip.search(highest, value));
+    EXPECT_FALSE(skip.remove(highest));
+    EXPECT_TRUE(skip.insert(highest, "max"));
+    EXPECT_TRUE(skip.insert(lowest, "min"));
+    EXPECT_TRUE(skip.search(highest, value));
+    EXPECT_EQ(value, "max");
+    EXPECT_TRUE(skip.search(lowest, value));
+    EXPECT_EQ(value, "min");
+    EXPECT_TRUE(skip.remove(highest));
+    EXPECT_FALSE(skip.search(highest, value));
+}
+
+TEST(LockFreeSkipListAllocatorTest, PoolAllocatorInsertSearchRemove) {
+    LockFreeSkipList<int, std::string, 16, HazardPointerReclamation, PoolAllocator<std::string>> skip;
+    std::string value;
+    for (int key = 0; key < 1000; ++key)
+        EXPECT_TRUE(skip.insert(key, std::to_string(key)));
+    for (int key = 0; key < 1000; key += 2)
+        EXPECT_TRUE(skip.remove(key));
+    for (int key = 0; key < 1000; ++key) {
+        EXPECT_EQ(skip.search(key, value), key % 2 == 1);
+        if (key % 2 == 1) {
+            EXPECT_EQ(value, std::to_string(key));
+        }
+    }
+}
+
+// The towers follow the nodes in the same allocation, they must neither overlap the values nor break their alignment
+TEST(LockFreeSkipListAllocatorTest, OverAlignedValuesNextToTowers) {
+    struct alignas(32) Wide {
+        int64_t words[4];
+    };
+    LockFreeSkipList<int, Wide, 16> skip;
+    for (int key = 0; key < 2000; ++key)
+        EXPECT_TRUE(skip.insert(key, Wide{{key, -key, 2 * key, key + 7}}));
+    for (int key = 0; key < 2000; key += 3)
+        EXPECT_TRUE(skip.remove(key));
+    Wide value{};
+    for (int key = 0; key < 2000; ++key) {
+        ASSERT_EQ(skip.search(key, value), key % 3 != 0);
+        if (key % 3 != 0) {
+            EXPECT_EQ(value.words[0], key);
+            EXPECT_EQ(value.words[1], -key);
+            EXPECT_EQ(value.words[2], 2 * key);
+            EXPECT_EQ(value.words[3], key + 7);
+        }
+    }
+}
+
+static_assert(std::forward_iterator<LockFreeSkipList<int, int, 16>::Iterator>);
+
+TEST(LockFreeSkipListOrderedTest, RangeScanAndBounds) {
+    LockFreeSkipList<int, int, 16> skip;
+    for (int key = 0; key < 100; key += 10)
+        EXPECT_TRUE(skip.insert(key, key * 2));
+    EXPECT_TRUE(skip.remove(50));
+
+    std::vector<std::pair<int, int>> scanned;
+    EXPECT_EQ(skip.range_scan(15, 80, [&](int key, int value) { scanned.emplace_back(key, value); }), 5u);
+    EXPECT_EQ(scanned, (std::vector<std::pair<int, int>>{{20, 40}, {30, 60}, {40, 80}, {60, 120}, {70, 140}}));
+    EXPECT_EQ(skip.range_scan(91, 1000, [](int, int) {}), 0u);
+
+    EXPECT_EQ(skip.lower_bound(20)->first, 20);
+    EXPECT_EQ(skip.lower_bound(41)->first, 60);
+    EXPECT_EQ(skip.upper_bound(20)->first, 30);
+    EXPECT_EQ(skip.upper_bound(20)->second, 60);
+    EXPECT_TRUE(skip.lower_bound(91) == skip.end());
+    EXPECT_TRUE(skip.upper_bound(std::numeric_limits<int>::max()) == skip.end());
+
+    std::vector<int> keys;
+    for (const auto& [key, value] : skip)
+        keys.push_back(key);
+    EXPECT_EQ(keys, (std::vector<int>{0, 10, 20, 30, 40, 60, 70, 80, 90}));
+}
+
+// The even keys stay present while other threads insert and remove the odd ones, so every scan has to see all even keys
+// exactly once and in ascending order
+TEST(LockFreeSkipListOrderedTest, ScansWhileOthersMutate) {
+    constexpr int keys = 2000;
+    LockFreeSkipList<int, int, 12> skip;
+    for (int key = 0; key < keys; key += 2)
+        skip.insert(key, key);
+    std::atomic<bool> done{false};
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 2; ++t) {
+        writers.emplace_back([&, t]() {
+            std::mt19937 generator(t);
+            while (!done.load()) {
+                const int key = static_cast<int>(generator() % (keys / 2)) * 2 + 1;
+                if (generator() % 2)
+                    skip.insert(key, key);
+                else
+                    skip.remove(key);
+            }
+        });
+    }
+    for (int round = 0; round < 20; ++round) {
+        int expected_even = 0;
+        int previous = -1;
+        skip.range_scan(0, keys, [&](int key, int value) {
+            EXPECT_GT(key, previous);
+            EXPECT_EQ(key, value);
+            previous = key;
+            if (key % 2 == 0) {
+                EXPECT_EQ(key, expected_even);
+                expected_even += 2;
+            }
+        });
+        EXPECT_EQ(expected_even, keys);
+
+        expected_even = 0;
+        previous = -1;
+        for (auto it = skip.begin(); it != skip.end(); ++it) {
+            EXPECT_GT(it->first, previous);
+            previous = it->first;
+            if (it->first % 2 == 0) {
+                EXPECT_EQ(it->first, expected_even);
+                expected_even += 2;
+            }
+        }
+        EXPECT_EQ(expected_even, keys);
+    }
+    done.store(true);
+    for (auto& writer : writers) writer.join();
+}
+
+// Level l has to be drawn with probability (1 - p) * p^l, on the countr_zero path for p = 2^-b and the comparing path
+TEST(LockFreeSkipListLevelTest, LevelsFollowTheProbability) {
+    constexpr int draws = 200000;
+    for (float probability : {0.5f, 0.25f, 0.3f}) {
+        SkipListLevels<16> levels(probability);
+        int at_least_one{}, at_least_two{};
+        for (int i = 0; i < draws; ++i) {
+            const int level = levels();
+            ASSERT_GE(level, 0);
+            ASSERT_LE(level, 16);
+            at_least_one += level >= 1;
+            at_least_two += level >= 2;
+        }
+        EXPECT_NEAR(static_cast<double>(at_least_one) / draws, probability, 0.01);
+        EXPECT_NEAR(static_cast<double>(at_least_two) / draws, probability * probability, 0.01);
+    }
+    EXPECT_EQ(SkipListLevels<16>(0.0f)(), 0);
+    EXPECT_EQ(SkipListLevels<16>(1.0f)(), 16);
+}
+
+TEST(LockFreeSkipListFingerTest, FingerSearchesMatchPlainSearches) {
+    LockFreeSkipList<int, int, 16> skip;
+    LockFreeSkipList<int, int, 16> other;
+    LockFreeSkipList<int, int, 16>::Finger finger;
+    std::mt19937 generator(7);
+    // Almost sorted keys with some jumps back and far ahead
+    for (int i = 0; i < 5000; ++i) {
+        const int key = i % 500 == 0 ? static_cast<int>(generator() % 20000) : i * 4 + static_cast<int>(generator() % 8);
+        EXPECT_EQ(skip.insert(key, key, &finger), other.insert(key, key));
+    }
+    for (int key = 0; key < 20000; key += 3) {
+        EXPECT_EQ(skip.remove(key, &finger), other.remove(key));
+    }
+    // The finger is reused on another list, it must start over there
+    int value, other_value;
+    for (int key = 0; key < 20000; ++key) {
+        const bool found = other.search(key, other_value, &finger);
+        ASSERT_EQ(skip.search(key, value, &finger), found);
+        ASSERT_EQ(skip.search(key, value), found);
+        if (found) {
+            EXPECT_EQ(value, other_value);
+        }
+    }
+}
+
+// Every thread inserts its own almost sorted keys with a finger while another thread removes them again, so fingers
+// keep pointing at nodes that get removed
+template<typename Reclamation>
+void finger_inserts_under_removal() {
+    constexpr int threads = 3;
+    constexpr int keys_per_thread = 5000;
+    LockFreeSkipList<int, int, 12, Reclamation> skip;
+    std::atomic<bool> done{false};
+    std::thread remover([&]() {
+        std::mt19937 generator(1);
+        while (!done.load()) {
+            const int key = static_cast<int>(generator() % (threads * keys_per_thread));
+            if (key % 2)
+                skip.remove(key);
+        }
+    });
+    std::vector<std::thread> inserters;
+    for (int t = 0; t < threads; ++t) {
+        inserters.emplace_back([&, t]() {
+            typename LockFreeSkipList<int, int, 12, Reclamation>::Finger finger;
+            for (int i = 0; i < keys_per_thread; ++i) {
+                const int key = i * threads + t;
+                EXPECT_TRUE(skip.insert(key, key, &finger));
+            }
+        });
+    }
+    for (auto& inserter : inserters) inserter.join();
+    done.store(true);
+    remover.join();
+    int value;
+    for (int key = 0; key < threads * keys_per_thread; key += 2) {
+        EXPECT_TRUE(skip.search(key, value));
+    }
+}
+
+TEST(LockFreeSkipListFingerTest, FingerInsertsUnderRemoval) {
+    finger_inserts_under_removal<HazardPointerReclamation>();
+}
+
+TEST(LockFreeSkipListFingerTest, EpochReclamationFingerInsertsUnderRemoval) {
+    finger_inserts_under_removal<EpochReclamation>();
+}
+
+TEST(LockFreeSkipListFingerTest, SecondLiveFingerThrows) {
+    LockFreeSkipList<int, int, 16> skip;
+    using Finger = LockFreeSkipList<int, int, 16>::Finger;
+    {
+        Finger first;
+    }
+    // The first finger is gone, so its slot can be taken again
+    Finger second;
+    for (int key = 0; key < 100; ++key)
+        EXPECT_TRUE(skip.insert(key, key, &second));
+    EXPECT_THROW(Finger third, std::logic_error);
+    EXPECT_THROW((LockFreeSkipList<long, long, 8>::Finger()), std::logic_error);
+    // The failed attempts left the live finger and its protection alone
+    int value;
+    EXPECT_TRUE(skip.search(99, value, &second));
+    EXPECT_TRUE(skip.insert(100, 100, &second));
+}
@@ -2,11 +2,16 @@
 // Created by andreas on 04.05.25.
 //
 #include "./../lock_free_stack.h"
+#include "./../epoch_reclamation.h"
+#include "./../pool_allocator.h"
 #include <gtest/gtest.h>
 #include <thread>
 #include <vector>
 #include <atomic>
+#include <memory>
 #include <random>
+#include <stdexcept>
+#include <string>
 
 TEST(LockFreeStackTest, EmptyStackThrows)
 {
@@ -295,3 +300,388 @@ TEST(LockFreeStackTest, MixedPushPopTopStress)
     // we should have seen at least one top()
     EXPECT_GT(tops.load(), 0);
 }
+
+
+TEST(LockFreeStackTest, EpochReclamationSingleThread)
+{
+    LockFreeStack<int, EpochReclamation> stack;
+    EXPECT_FALSE(stack.pop().has_value());
+    EXPECT_FALSE(stack.top().has_value());
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        stack.push(i);
+    }
+    EXPECT_EQ(stack.top(), 999);
+    for (int i = 999; i >= 0; --i)
+    {
+        EXPECT_EQ(stack.pop(), i);
+    }
+    EXPECT_TRUE(stack.empty());
+}
+
+template <typename Reclamation>
+void concurrent_push_pop_top()
+{
+    constexpr int kNumThreads = 4;
+    constexpr int kOpsPerThread = 20000;
+
+    LockFreeStack<int, Reclamation> stack;
+    std::atomic<int> pop_count{0};
+    std::atomic<long long> sum_pop{0};
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < kNumThreads; ++thread)
+    {
+        threads.emplace_back([&, thread]()
+        {
+            for (int j = 0; j < kOpsPerThread; ++j)
+            {
+                stack.push(thread * kOpsPerThread + j);
+            }
+        });
+    }
+    for (int thread = 0; thread < kNumThreads; ++thread)
+    {
+        threads.emplace_back([&]()
+        {
+            while (pop_count.load(std::memory_order_acquire) < kNumThreads * kOpsPerThread)
+            {
+                if (auto v = stack.top())
+                {
+                    EXPECT_GE(v.value(), 0);
+                }
+                if (auto v = stack.pop())
+                {
+                    sum_pop.fetch_add(v.value(), std::memory_order_relaxed);
+                    pop_count.fetch_add(1, std::memory_order_release);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    constexpr long long total = kNumThreads * kOpsPerThread;
+    EXPECT_EQ(pop_count.load(), total);
+    EXPECT_EQ(sum_pop.load(), total * (total - 1) / 2);
+    EXPECT_FALSE(stack.pop().has_value());
+}
+
+TEST(LockFreeStackTest, EpochReclamationConcurrentPushPopTop)
+{
+    concurrent_push_pop_top<EpochReclamation>();
+}
+
+TEST(LockFreeStackTest, AsymmetricFenceConcurrentPushPopTop)
+{
+    concurrent_push_pop_top<AsymmetricHazardPointerReclamation>();
+}
+
+TEST(LockFreeStackTest, EliminationArrayHandsNodeFromPusherToPopper)
+{
+    EliminationArray<StackNode<int>> elimination;
+    StackNode<int> node(42);
+    StackNode<int>* received = nullptr;
+
+    std::thread pusher([&]()
+    {
+        while (!elimination.try_push(&node));
+    });
+    std::thread popper([&]()
+    {
+        while (!(received = elimination.try_pop()));
+    });
+    pusher.join();
+    popper.join();
+
+    EXPECT_EQ(received, &node);
+    EXPECT_EQ(elimination.try_pop(), nullptr);
+}
+
+TEST(LockFreeStackTest, EliminationBackoffPushPopPairs)
+{
+    constexpr int kNumThreads = 16;
+    constexpr int kOpsPerThread = 20000;
+
+    LockFreeStack<int, HazardPointerReclamation, EliminationBackoff> stack;
+    std::atomic<long long> sum_pop{0};
+
+    // Every thread pushes and pops alternately, so pushes and pops collide all the time
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < kNumThreads; ++thread)
+    {
+        threads.emplace_back([&, thread]()
+        {
+            for (int j = 0; j < kOpsPerThread; ++j)
+            {
+                stack.push(thread * kOpsPerThread + j);
+                auto v = stack.pop();
+                ASSERT_TRUE(v.has_value());
+                sum_pop.fetch_add(v.value(), std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    constexpr long long total = kNumThreads * kOpsPerThread;
+    EXPECT_EQ(sum_pop.load(), total * (total - 1) / 2);
+    EXPECT_FALSE(stack.pop().has_value());
+}
+
+TEST(LockFreeStackTest, PoolAllocatorConcurrentPushPop)
+{
+    constexpr int kNumThreads = 8;
+    constexpr int kOpsPerThread = 20000;
+
+    LockFreeStack<int, HazardPointerReclamation, NoBackoff, PoolAllocator<int>> stack;
+    std::atomic<long long> sum_pop{0};
+
+    // Nodes are pushed by one thread and freed by another, so they travel back to their owner's pool
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < kNumThreads; ++thread)
+    {
+        threads.emplace_back([&, thread]()
+        {
+            for (int j = 0; j < kOpsPerThread; ++j)
+            {
+                stack.push(thread * kOpsPerThread + j);
+                auto v = stack.pop();
+                ASSERT_TRUE(v.has_value());
+                sum_pop.fetch_add(v.value(), std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    constexpr long long total = kNumThreads * kOpsPerThread;
+    EXPECT_EQ(sum_pop.load(), total * (total - 1) / 2);
+    stack.push(1);
+}
+
+TEST(LockFreeStackTest, BulkOperationsSingleThread)
+{
+    LockFreeStack<int> stack;
+    const std::vector<int> values{1, 2, 3, 4, 5};
+    stack.push_range(values.begin(), values.end());
+    EXPECT_EQ(stack.top(), 5);
+
+    EXPECT_EQ(stack.pop_n(2), (std::vector<int>{5, 4}));
+    EXPECT_EQ(stack.pop_n(0), std::vector<int>{});
+    stack.push(6);
+    EXPECT_EQ(stack.pop_all(), (std::vector<int>{6, 3, 2, 1}));
+    EXPECT_TRUE(stack.empty());
+    EXPECT_EQ(stack.pop_all(), std::vector<int>{});
+
+    stack.push_range(values.begin(), values.end());
+    EXPECT_EQ(stack.pop_n(10), (std::vector<int>{5, 4, 3, 2, 1}));
+    EXPECT_EQ(stack.pop_n(1), std::vector<int>{});
+}
+
+template <typename Reclamation>
+void concurrent_bulk_push_pop()
+{
+    constexpr int kNumThreads = 4;
+    constexpr int kBatches = 500;
+    constexpr int kBatchSize = 64;
+
+    LockFreeStack<int, Reclamation> stack;
+    std::atomic<int> pop_count{0};
+    std::atomic<long long> sum_pop{0};
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < kNumThreads; ++thread)
+    {
+        threads.emplace_back([&, thread]()
+        {
+            std::vector<int> batch(kBatchSize);
+            for (int b = 0; b < kBatches; ++b)
+            {
+                for (int i = 0; i < kBatchSize; ++i)
+                    batch[i] = (thread * kBatches + b) * kBatchSize + i;
+                stack.push_range(batch.begin(), batch.end());
+            }
+        });
+    }
+    for (int thread = 0; thread < kNumThreads; ++thread)
+    {
+        // Mix all three ways of popping
+        threads.emplace_back([&, thread]()
+        {
+            while (pop_count.load(std::memory_order_acquire) < kNumThreads * kBatches * kBatchSize)
+            {
+                std::vector<int> popped;
+                if (thread == 0)
+                    popped = stack.pop_all();
+                else if (auto v = stack.pop())
+                    popped.push_back(v.value());
+                else
+                    popped = stack.pop_n(thread * 7);
+                for (int v : popped)
+                    sum_pop.fetch_add(v, std::memory_order_relaxed);
+                pop_count.fetch_add(static_cast<int>(popped.size()), std::memory_order_release);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    constexpr long long total = kNumThreads * kBatches * kBatchSize;
+    EXPECT_EQ(pop_count.load(), total);
+    EXPECT_EQ(sum_pop.load(), total * (total - 1) / 2);
+    EXPECT_TRUE(stack.empty());
+}
+
+TEST(LockFreeStackTest, BulkOperationsConcurrent)
+{
+    concurrent_bulk_push_pop<HazardPointerReclamation>();
+}
+
+TEST(LockFreeStackTest, BulkOperationsConcurrentEpochReclamation)
+{
+    concurrent_bulk_push_pop<EpochReclamation>();
+}
+
+TEST(LockFreeStackTest, MoveOnlyValues)
+{
+    LockFreeStack<std::unique_ptr<int>> stack;
+    stack.push(std::make_unique<int>(1));
+    stack.emplace(new int(2));
+    stack.emplace(std::make_unique<int>(3));
+
+    auto value = stack.pop();
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(**value, 3);
+    auto rest = stack.pop_n(5);
+    ASSERT_EQ(rest.size(), 2u);
+    EXPECT_EQ(*rest[0], 2);
+    EXPECT_EQ(*rest[1], 1);
+    EXPECT_TRUE(stack.empty());
+}
+
+namespace
+{
+    struct CopyCounter
+    {
+        static inline std::atomic<int> copies{0};
+        std::string text;
+
+        explicit CopyCounter(std::string text) : text(std::move(text))
+        {
+        }
+
+        CopyCounter(const CopyCounter& other) : text(other.text)
+        {
+            copies.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        CopyCounter(CopyCounter&&) noexcept = default;
+    };
+}
+
+TEST(LockFreeStackTest, ValuesAreMovedInAndOut)
+{
+    LockFreeStack<CopyCounter> stack;
+    CopyCounter::copies = 0;
+
+    stack.push(CopyCounter("moved in"));
+    stack.emplace("constructed in place");
+    EXPECT_EQ(stack.pop()->text, "constructed in place");
+    EXPECT_EQ(stack.pop()->text, "moved in");
+    EXPECT_EQ(CopyCounter::copies.load(), 0);
+
+    // top() copies, and so does pushing an lvalue. Once top() was used, pops copy as well.
+    const CopyCounter value("copied in");
+    stack.push(value);
+    EXPECT_EQ(stack.top()->text, "copied in");
+    EXPECT_EQ(stack.pop_all().size(), 1u);
+    EXPECT_EQ(CopyCounter::copies.load(), 3);
+    stack.emplace("copied out");
+    EXPECT_EQ(stack.pop()->text, "copied out");
+    EXPECT_EQ(CopyCounter::copies.load(), 4);
+}
+
+namespace
+{
+    // Counts its live instances; the copy constructor throws once copies_left reaches zero
+    struct ThrowingCopy
+    {
+        static inline int live{0};
+        static inline int copies_left{0};
+        int value;
+
+        explicit ThrowingCopy(int value) : value(value)
+        {
+            ++live;
+        }
+
+        ThrowingCopy(const ThrowingCopy& other) : value(other.value)
+        {
+            if (copies_left-- == 0)
+                throw std::runtime_error("copy failed");
+            ++live;
+        }
+
+        ~ThrowingCopy()
+        {
+            --live;
+        }
+    };
+}
+
+TEST(LockFreeStackTest, PushRangeReleasesChainIfCopyThrows)
+{
+    LockFreeStack<ThrowingCopy> stack;
+    {
+        std::vector<ThrowingCopy> values;
+        values.reserve(5);
+        for (int i = 0; i < 5; ++i)
+            values.emplace_back(i);
+        ThrowingCopy::copies_left = 3;
+        EXPECT_THROW(stack.push_range(values.begin(), values.end()), std::runtime_error);
+        // The three nodes built before the failing copy are gone again, nothing was pushed
+        EXPECT_EQ(ThrowingCopy::live, 5);
+        EXPECT_TRUE(stack.empty());
+
+        ThrowingCopy::copies_left = 100;
+        stack.push_range(values.begin(), values.end());
+    }
+    EXPECT_EQ(ThrowingCopy::live, 5);
+    EXPECT_EQ(stack.pop_all().size(), 5u);
+}
+
+TEST(LockFreeStackTest, ConcurrentTopNeverSeesMovedFromValues)
+{
+    constexpr int kNumThreads = 4;
+    constexpr int kOpsPerThread = 5000;
+    // Long enough to live on the heap, a moved-from string would be empty
+    const std::string payload(64, 'x');
+
+    LockFreeStack<std::string> stack;
+    std::atomic<int> pop_count{0};
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < kNumThreads; ++thread)
+    {
+        threads.emplace_back([&]()
+        {
+            for (int j = 0; j < kOpsPerThread; ++j)
+                stack.push(std::string(payload));
+        });
+        threads.emplace_back([&]()
+        {
+            while (pop_count.load(std::memory_order_acquire) < kNumThreads * kOpsPerThread)
+            {
+                if (auto v = stack.top())
+                {
+                    EXPECT_EQ(*v, payload);
+                }
+                if (auto v = stack.pop())
+                {
+                    EXPECT_EQ(*v, payload);
+                    pop_count.fetch_add(1, std::memory_order_release);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_TRUE(stack.empty());
+}
@@ -0,0 +1,91 @@
+//
+// Created by andreas on 18.10.26.
+//
+#include <thread>
+#include <vector>
+
+#include "./../packed_lock_free_hash_table.h"
+#include "gtest/gtest.h"
+
+using PackedHashTable = PackedLockFreeHashTable<int32_t, int32_t, -1, -1, 1024>;
+
+TEST(PackedLockFreeHashTableTest, InsertAndLookupSingleThread)
+{
+    PackedHashTable table;
+    EXPECT_EQ(table.lookup(42), PackedHashTable::no_value);
+    EXPECT_TRUE(table.insert(42, 100));
+    EXPECT_EQ(table.lookup(42), 100);
+
+    // Update existing key
+    EXPECT_TRUE(table.insert(42, 300));
+    EXPECT_EQ(table.lookup(42), 300);
+}
+
+TEST(PackedLockFreeHashTableTest, FullTableRejectsNewKeys)
+{
+    PackedHashTable table;
+    for (int i = 0; i < 1024; ++i)
+    {
+        EXPECT_TRUE(table.insert(i, i * 10));
+    }
+    EXPECT_FALSE(table.insert(2048, 9999));
+    EXPECT_TRUE(table.insert(7, 1));
+    EXPECT_EQ(table.lookup(7), 1);
+}
+
+TEST(PackedLockFreeHashTableTest, SmallKeysAndFloatValues)
+{
+    PackedLockFreeHashTable<int16_t, float, -1, -1.0f, 64> table;
+    EXPECT_TRUE(table.insert(3, 0.5f));
+    EXPECT_TRUE(table.insert(-7, 2.25f));
+    EXPECT_EQ(table.lookup(3), 0.5f);
+    EXPECT_EQ(table.lookup(-7), 2.25f);
+    EXPECT_EQ(table.lookup(4), -1.0f);
+}
+
+TEST(PackedLockFreeHashTableTest, ConcurrentInsertsNeverExposeKeyWithoutValue)
+{
+    constexpr int num_threads = 8;
+    constexpr int inserts_per_thread = 256;
+    constexpr int key_count = num_threads * inserts_per_thread;
+
+    for (int repeat = 0; repeat < 20; ++repeat)
+    {
+        PackedLockFreeHashTable<int32_t, int32_t, -1, -1, 4096> table;
+        std::atomic<bool> inserting{true};
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < num_threads; ++thread)
+        {
+            threads.emplace_back([&table, thread]()
+            {
+                for (int i = 0; i < inserts_per_thread; ++i)
+                {
+                    int key = thread * inserts_per_thread + i;
+                    EXPECT_TRUE(table.insert(key, key * 10));
+                }
+            });
+        }
+        std::thread reader([&]()
+        {
+            while (inserting.load())
+            {
+                for (int key = 0; key < key_count; ++key)
+                {
+                    auto value = table.lookup(key);
+                    EXPECT_TRUE(value == PackedHashTable::no_value || value == key * 10);
+                }
+            }
+        });
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        inserting.store(false);
+        reader.join();
+
+        for (int key = 0; key < key_count; ++key)
+        {
+            EXPECT_EQ(table.lookup(key), key * 10);
+        }
+    }
+}
@@ -0,0 +1,108 @@
+//
+// Created by andreas on 18.10.26.
+//
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "./../lock_free_hash_table.h"
+#include "./../parallel_top_down.h"
+#include "gtest/gtest.h"
+
+namespace
+{
+    constexpr size_t memo_table_size = 1 << 18;
+    using MemoTable = LockFreeHashTable<int64_t, int32_t, -1, -1, memo_table_size, MixingHash<int64_t>, -2>;
+
+    std::string random_string(size_t length, unsigned seed)
+    {
+        std::mt19937 generator(seed);
+        std::string result(length, 'a');
+        for (auto& c : result)
+            c = static_cast<char>('a' + generator() % 4);
+        return result;
+    }
+
+    int32_t serial_lcs(const std::string& a, const std::string& b)
+    {
+        std::vector<std::vector<int32_t>> lengths(a.size() + 1, std::vector<int32_t>(b.size() + 1, 0));
+        for (size_t i = 1; i <= a.size(); ++i)
+            for (size_t j = 1; j <= b.size(); ++j)
+                lengths[i][j] = a[i - 1] == b[j - 1]
+                                    ? lengths[i - 1][j - 1] + 1
+                                    : std::max(lengths[i - 1][j], lengths[i][j - 1]);
+        return lengths[a.size()][b.size()];
+    }
+
+    // Longest common subsequence of the prefixes a[0, i) and b[0, j), keyed by i * (b.size() + 1) + j
+    struct LcsSolver
+    {
+        const std::string& a;
+        const std::string& b;
+
+        template <typename Context>
+        int32_t operator()(int64_t key, Context& context) const
+        {
+            const auto columns = static_cast<int64_t>(b.size() + 1);
+            const int64_t i = key / columns, j = key % columns;
+            if (i == 0 || j == 0)
+                return 0;
+            if (a[i - 1] == b[j - 1])
+                return context(key - columns - 1) + 1;
+            context.spawn(key - 1);
+            const int32_t up = context(key - columns);
+            return std::max(up, context(key - 1));
+        }
+    };
+}
+
+TEST(ParallelTopDownTest, LongestCommonSubsequenceMatchesSerial)
+{
+    const std::string a = random_string(300, 1);
+    const std::string b = random_string(400, 2);
+    const int32_t expected = serial_lcs(a, b);
+    for (size_t threads : {1, 2, 4, 8})
+    {
+        auto table = std::make_unique<MemoTable>();
+        const int64_t root = static_cast<int64_t>(a.size() * (b.size() + 1) + b.size());
+        EXPECT_EQ(parallel_top_down(*table, root, LcsSolver{a, b}, threads), expected);
+    }
+}
+
+TEST(ParallelTopDownTest, KnapsackMatchesSerial)
+{
+    constexpr int32_t capacity = 500;
+    std::mt19937 generator(3);
+    std::vector<int32_t> weights(60), values(60);
+    for (size_t item = 0; item < weights.size(); ++item)
+    {
+        weights[item] = static_cast<int32_t>(1 + generator() % 50);
+        values[item] = static_cast<int32_t>(1 + generator() % 100);
+    }
+    std::vector<int32_t> best(capacity + 1, 0);
+    for (size_t item = 0; item < weights.size(); ++item)
+        for (int32_t w = capacity; w >= weights[item]; --w)
+            best[w] = std::max(best[w], best[w - weights[item]] + values[item]);
+
+    // Best value of the first i items within weight w, keyed by i * (capacity + 1) + w
+    auto solver = [&](int64_t key, auto& context) -> int32_t
+    {
+        const int64_t i = key / (capacity + 1), w = key % (capacity + 1);
+        if (i == 0)
+            return 0;
+        const int64_t skip = key - (capacity + 1);
+        if (weights[i - 1] > w)
+            return context(skip);
+        context.spawn(skip);
+        const int32_t take = context(skip - weights[i - 1]) + values[i - 1];
+        return std::max(take, context(skip));
+    };
+    for (size_t threads : {1, 4})
+    {
+        auto table = std::make_unique<MemoTable>();
+        const int64_t root = static_cast<int64_t>(weights.size()) * (capacity + 1) + capacity;
+        EXPECT_EQ(parallel_top_down(*table, root, solver, threads), best[capacity]);
+    }
+}
@@ -0,0 +1,92 @@
+//
+// Created by andreas on 18.10.26.
+//
+#include "./../pool_allocator.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+TEST(PoolAllocatorTest, FreedBlockIsReusedBySameThread)
+{
+    PoolAllocator<std::uint64_t> allocator;
+    std::uint64_t* first = allocator.allocate(1);
+    allocator.deallocate(first, 1);
+    std::uint64_t* second = allocator.allocate(1);
+    EXPECT_EQ(first, second);
+    allocator.deallocate(second, 1);
+}
+
+TEST(PoolAllocatorTest, SizeClassesDoNotShareBlocks)
+{
+    PoolAllocator<char> allocator;
+    char* small = allocator.allocate(16);
+    allocator.deallocate(small, 16);
+    char* large = allocator.allocate(100);
+    EXPECT_NE(small, large);
+    std::fill(large, large + 100, 'x');
+    allocator.deallocate(large, 100);
+
+    // Larger than the largest size class, bypasses the pool
+    char* huge = allocator.allocate(2 * pool_max_block_size);
+    std::fill(huge, huge + 2 * pool_max_block_size, 'x');
+    allocator.deallocate(huge, 2 * pool_max_block_size);
+}
+
+TEST(PoolAllocatorTest, BlockFreedByOtherThreadReturnsToOwner)
+{
+    PoolAllocator<std::uint64_t> allocator;
+    std::uint64_t* block = allocator.allocate(1);
+    std::thread([&]() { allocator.deallocate(block, 1); }).join();
+
+    // The block sits on the remote list until the local list of its size class is exhausted
+    std::vector<std::uint64_t*> allocated;
+    bool returned = false;
+    for (std::size_t i = 0; i < 2 * pool_chunk_size / pool_min_block_size && !returned; ++i)
+    {
+        allocated.push_back(allocator.allocate(1));
+        returned = allocated.back() == block;
+    }
+    EXPECT_TRUE(returned);
+    for (auto* pointer : allocated)
+        allocator.deallocate(pointer, 1);
+}
+
+TEST(PoolAllocatorTest, ConcurrentCrossThreadFrees)
+{
+    constexpr int kNumThreads = 8;
+    constexpr int kBlocksPerThread = 10000;
+    PoolAllocator<std::uint64_t> allocator;
+    std::vector<std::vector<std::uint64_t*>> blocks(kNumThreads);
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < kNumThreads; ++thread)
+    {
+        threads.emplace_back([&, thread]()
+        {
+            for (int i = 0; i < kBlocksPerThread; ++i)
+            {
+                blocks[thread].push_back(allocator.allocate(1));
+                *blocks[thread].back() = thread;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    threads.clear();
+
+    // Every thread frees the blocks allocated by its neighbour
+    for (int thread = 0; thread < kNumThreads; ++thread)
+    {
+        threads.emplace_back([&, thread]()
+        {
+            const int owner = (thread + 1) % kNumThreads;
+            for (auto* pointer : blocks[owner])
+            {
+                EXPECT_EQ(*pointer, static_cast<std::uint64_t>(owner));
+                allocator.deallocate(pointer, 1);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+}
@@ -0,0 +1,255 @@
+//
+// Created by andreas on 18.10.26.
+//
+#include <thread>
+#include <vector>
+
+#include "./../resizable_lock_free_hash_table.h"
+#include "gtest/gtest.h"
+
+using ResizableHashTable = ResizableLockFreeHashTable<int64_t, int32_t, -1, -1, -2>;
+
+TEST(ResizableLockFreeHashTableTest, InsertAndLookupSingleThread)
+{
+    ResizableHashTable table(4);
+    EXPECT_EQ(table.lookup(42), ResizableHashTable::no_value);
+    EXPECT_TRUE(table.insert(42, 100));
+    EXPECT_EQ(table.lookup(42), 100);
+
+    // Update existing key
+    EXPECT_TRUE(table.insert(42, 300));
+    EXPECT_EQ(table.lookup(42), 300);
+}
+
+TEST(ResizableLockFreeHashTableTest, GrowsInsteadOfRunningFull)
+{
+    ResizableHashTable table(16);
+    // Far more keys than the initial capacity, the fixed size table would reject most of them
+    for (int i = 0; i < 10000; ++i)
+    {
+        EXPECT_TRUE(table.insert(i, i * 10));
+    }
+    EXPECT_GE(table.capacity(), 10000u);
+    for (int i = 0; i < 10000; ++i)
+    {
+        EXPECT_EQ(table.lookup(i), i * 10);
+    }
+    EXPECT_EQ(table.lookup(10000), ResizableHashTable::no_value);
+}
+
+TEST(ResizableLockFreeHashTableTest, ConcurrentInsertsDuringMigration)
+{
+    ResizableHashTable table(16);
+    constexpr int num_threads = 8;
+    constexpr int inserts_per_thread = 20000;
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < num_threads; ++thread)
+    {
+        threads.emplace_back([&table, thread]()
+        {
+            for (int i = 0; i < inserts_per_thread; ++i)
+            {
+                int key = thread * inserts_per_thread + i;
+                EXPECT_TRUE(table.insert(key, key % 1000));
+                // Keys of this thread stay visible while the table grows underneath
+                int earlier = thread * inserts_per_thread + i / 2;
+                EXPECT_EQ(table.lookup(earlier), earlier % 1000);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (int key = 0; key < num_threads * inserts_per_thread; ++key)
+    {
+        EXPECT_EQ(table.lookup(key), key % 1000);
+    }
+}
+
+TEST(ResizableLockFreeHashTableTest, UpdatesAreNotLostDuringMigration)
+{
+    ResizableHashTable table(16);
+    constexpr int num_writers = 4;
+    constexpr int keys_per_writer = 64;
+    constexpr int rounds = 200;
+    std::atomic<bool> done{false};
+
+    // Each writer owns its keys and increases their values round by round, while another thread keeps the table
+    // growing. A reader checks that no value ever goes back, i.e. no migration resurrects an old value.
+    std::vector<std::thread> threads;
+    for (int writer = 0; writer < num_writers; ++writer)
+    {
+        threads.emplace_back([&table, writer]()
+        {
+            for (int round = 0; round < rounds; ++round)
+            {
+                for (int i = 0; i < keys_per_writer; ++i)
+                {
+                    table.insert(writer * keys_per_writer + i, round);
+                }
+            }
+        });
+    }
+    threads.emplace_back([&table]()
+    {
+        for (int key = 1000000; key < 1050000; ++key)
+        {
+            table.insert(key, 1);
+        }
+    });
+    std::thread reader([&table, &done]()
+    {
+        std::vector<int32_t> last_seen(num_writers * keys_per_writer, -1);
+        while (!done.load())
+        {
+            for (int key = 0; key < num_writers * keys_per_writer; ++key)
+            {
+                int32_t value = table.lookup(key);
+                EXPECT_GE(value, last_seen[key]);
+                last_seen[key] = value;
+            }
+        }
+    });
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    done.store(true);
+    reader.join();
+
+    for (int key = 0; key < num_writers * keys_per_writer; ++key)
+    {
+        EXPECT_EQ(table.lookup(key), rounds - 1);
+    }
+}
+
+TEST(ResizableLockFreeHashTableTest, EraseAndReinsert)
+{
+    ResizableHashTable table(16);
+    EXPECT_FALSE(table.erase(1));
+    EXPECT_TRUE(table.insert(1, 10));
+    EXPECT_TRUE(table.insert(2, 20));
+    EXPECT_TRUE(table.erase(1));
+    EXPECT_FALSE(table.erase(1));
+    EXPECT_EQ(table.lookup(1), ResizableHashTable::no_value);
+    EXPECT_EQ(table.lookup(2), 20);
+    EXPECT_TRUE(table.insert(1, 11));
+    EXPECT_EQ(table.lookup(1), 11);
+}
+
+TEST(ResizableLockFreeHashTableTest, ChurnIsCompactedInsteadOfGrowing)
+{
+    ResizableHashTable table(1024);
+    // Never more than 64 keys are alive, but every round uses new ones
+    for (int key = 0; key < 200000; ++key)
+    {
+        EXPECT_TRUE(table.insert(key, key % 1000));
+        if (key >= 64)
+        {
+            EXPECT_TRUE(table.erase(key - 64));
+        }
+    }
+    EXPECT_EQ(table.capacity(), 1024u);
+    for (int key = 200000 - 64; key < 200000; ++key)
+    {
+        EXPECT_EQ(table.lookup(key), key % 1000);
+    }
+    EXPECT_EQ(table.lookup(200000 - 65), ResizableHashTable::no_value);
+
+    table.compact();
+    EXPECT_EQ(table.capacity(), 1024u);
+    EXPECT_EQ(table.lookup(200000 - 1), 999);
+}
+
+TEST(ResizableLockFreeHashTableTest, ErasedValuesStayErasedDuringMigration)
+{
+    ResizableHashTable table(16);
+    constexpr int num_threads = 4;
+    constexpr int keys_per_thread = 20000;
+
+    // Every thread inserts its keys and erases every other one right away while the table keeps migrating. An erased
+    // key must not be resurrected by a copy made before the erase.
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < num_threads; ++thread)
+    {
+        threads.emplace_back([&table, thread]()
+        {
+            for (int i = 0; i < keys_per_thread; ++i)
+            {
+                int key = thread * keys_per_thread + i;
+                EXPECT_TRUE(table.insert(key, key % 1000));
+                if (key % 2 == 0)
+                {
+                    EXPECT_TRUE(table.erase(key));
+                    EXPECT_EQ(table.lookup(key), ResizableHashTable::no_value);
+                }
+            }
+        });
+    }
+    std::thread compactor([&table]()
+    {
+        for (int i = 0; i < 20; ++i)
+        {
+            table.compact();
+        }
+    });
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    compactor.join();
+
+    for (int key = 0; key < num_threads * keys_per_thread; ++key)
+    {
+        EXPECT_EQ(table.lookup(key), key % 2 == 0 ? ResizableHashTable::no_value : key % 1000);
+    }
+}
+
+TEST(ResizableLockFreeHashTableTest, InsertsDuringCompaction)
+{
+    ResizableHashTable table(1024);
+    constexpr int num_threads = 8;
+    constexpr int inserts_per_thread = 5000;
+    std::atomic<bool> done{false};
+
+    // Leave mostly tombstones behind, so every compact() migrates into a table of the same capacity
+    for (int key = 0; key < 700; ++key)
+    {
+        EXPECT_TRUE(table.insert(1000000 + key, 1));
+        EXPECT_TRUE(table.erase(1000000 + key));
+    }
+    // New keys keep arriving while the table is compacted over and over; none may get lost or overflow the successor
+    std::thread compactor([&table, &done]()
+    {
+        while (!done.load())
+        {
+            table.compact();
+        }
+    });
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < num_threads; ++thread)
+    {
+        threads.emplace_back([&table, thread]()
+        {
+            for (int i = 0; i < inserts_per_thread; ++i)
+            {
+                int key = thread * inserts_per_thread + i;
+                EXPECT_TRUE(table.insert(key, key % 1000));
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    done.store(true);
+    compactor.join();
+
+    for (int key = 0; key < num_threads * inserts_per_thread; ++key)
+    {
+        EXPECT_EQ(table.lookup(key), key % 1000);
+    }
+}
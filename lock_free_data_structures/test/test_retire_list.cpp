@@ -0,0 +1,75 @@
+//
+// Created by andreas on 18.10.26.
+//
+#include "./../retire_list.h"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct CountedNode : RetireListHook<CountedNode>
+    {
+        static inline std::atomic<int> deleted{0};
+
+        ~CountedNode()
+        {
+            deleted.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+}
+
+TEST(RetireListTest, ScanIsDeferredUntilThreshold)
+{
+    CountedNode::deleted = 0;
+    RetireList<CountedNode> retire_list;
+    for (std::size_t i = 0; i + 1 < retire_scan_minimum; ++i)
+    {
+        retire_list.retire(new CountedNode);
+    }
+    EXPECT_EQ(CountedNode::deleted.load(), 0);
+
+    // Crossing the threshold frees the whole batch at once
+    retire_list.retire(new CountedNode);
+    EXPECT_EQ(CountedNode::deleted.load(), static_cast<int>(retire_scan_minimum));
+}
+
+TEST(RetireListTest, ProtectedNodeSurvivesScan)
+{
+    CountedNode::deleted = 0;
+    auto* protected_node = new CountedNode;
+    {
+        RetireList<CountedNode> retire_list;
+        get_hazard_pointer().store(protected_node);
+        retire_list.retire(protected_node);
+        for (std::size_t i = 1; i < retire_scan_minimum; ++i)
+        {
+            retire_list.retire(new CountedNode);
+        }
+        EXPECT_EQ(CountedNode::deleted.load(), static_cast<int>(retire_scan_minimum) - 1);
+
+        get_hazard_pointer().store(nullptr);
+        retire_list.delete_unused_nodes();
+        EXPECT_EQ(CountedNode::deleted.load(), static_cast<int>(retire_scan_minimum));
+    }
+}
+
+TEST(RetireListTest, NodesOfExitedThreadAreAdopted)
+{
+    CountedNode::deleted = 0;
+    auto* protected_node = new CountedNode;
+    RetireList<CountedNode> retire_list;
+    get_hazard_pointer().store(protected_node);
+
+    // The thread exits with one protected node left, which is handed over to the orphans
+    std::thread([&retire_list, protected_node]
+    {
+        retire_list.retire(protected_node);
+        retire_list.retire(new CountedNode);
+    }).join();
+    EXPECT_EQ(CountedNode::deleted.load(), 1);
+
+    get_hazard_pointer().store(nullptr);
+    retire_list.delete_unused_nodes();
+    EXPECT_EQ(CountedNode::deleted.load(), 2);
+}
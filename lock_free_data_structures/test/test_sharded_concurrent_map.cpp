@@ -0,0 +1,119 @@
+//
+// Created by andreas on 18.10.26.
+//
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./../sharded_concurrent_map.h"
+#include "gtest/gtest.h"
+
+using StringMap = ShardedConcurrentMap<std::string, std::string>;
+
+TEST(ShardedConcurrentMapTest, StringKeysAndValues)
+{
+    StringMap map;
+    EXPECT_FALSE(map.lookup("answer").has_value());
+    EXPECT_TRUE(map.insert_or_assign("answer", "forty-two"));
+    EXPECT_EQ(map.lookup("answer"), "forty-two");
+
+    // Update existing key
+    EXPECT_FALSE(map.insert_or_assign("answer", "42"));
+    EXPECT_EQ(map.lookup("answer"), "42");
+    EXPECT_EQ(map.size(), 1u);
+
+    EXPECT_TRUE(map.erase("answer"));
+    EXPECT_FALSE(map.erase("answer"));
+    EXPECT_FALSE(map.lookup("answer").has_value());
+    EXPECT_EQ(map.size(), 0u);
+    EXPECT_TRUE(map.insert_or_assign("answer", "again"));
+    EXPECT_EQ(map.lookup("answer"), "again");
+}
+
+TEST(ShardedConcurrentMapTest, GrowsBucketsWhileKeepingAllKeys)
+{
+    // A single shard, so all keys go through one list and its bucket array doubles many times
+    ShardedConcurrentMap<int64_t, int32_t> map(1);
+    for (int i = 0; i < 100000; ++i)
+    {
+        EXPECT_TRUE(map.insert_or_assign(i, i * 10));
+    }
+    EXPECT_EQ(map.size(), 100000u);
+    for (int i = 0; i < 100000; ++i)
+    {
+        EXPECT_EQ(map.lookup(i), i * 10);
+    }
+    for (int i = 0; i < 100000; i += 2)
+    {
+        EXPECT_TRUE(map.erase(i));
+    }
+    for (int i = 0; i < 100000; ++i)
+    {
+        EXPECT_EQ(map.lookup(i).has_value(), i % 2 == 1);
+    }
+}
+
+TEST(ShardedConcurrentMapTest, ConcurrentInsertEraseLookup)
+{
+    StringMap map(4);
+    constexpr int num_threads = 8;
+    constexpr int keys_per_thread = 2000;
+    std::atomic<bool> done{false};
+
+    // Writers own disjoint keys, insert, overwrite and erase them; readers check that a key only ever maps to one of
+    // the values written for it
+    std::vector<std::thread> writers;
+    for (int thread = 0; thread < num_threads; ++thread)
+    {
+        writers.emplace_back([&map, thread]()
+        {
+            for (int round = 0; round < 3; ++round)
+            {
+                for (int i = 0; i < keys_per_thread; ++i)
+                {
+                    const std::string key = "key-" + std::to_string(thread * keys_per_thread + i);
+                    map.insert_or_assign(key, key + "-first");
+                    map.insert_or_assign(key, key + "-second");
+                    if (i % 3 == 0)
+                    {
+                        EXPECT_TRUE(map.erase(key));
+                    }
+                }
+            }
+        });
+    }
+    std::thread reader([&]()
+    {
+        while (!done.load())
+        {
+            for (int key_index = 0; key_index < num_threads * keys_per_thread; key_index += 7)
+            {
+                const std::string key = "key-" + std::to_string(key_index);
+                if (auto value = map.lookup(key))
+                {
+                    EXPECT_TRUE(*value == key + "-first" || *value == key + "-second");
+                }
+            }
+        }
+    });
+    for (auto& writer : writers)
+    {
+        writer.join();
+    }
+    done.store(true);
+    reader.join();
+
+    for (int key_index = 0; key_index < num_threads * keys_per_thread; ++key_index)
+    {
+        const std::string key = "key-" + std::to_string(key_index);
+        if (key_index % keys_per_thread % 3 == 0)
+        {
+            EXPECT_FALSE(map.lookup(key).has_value());
+        }
+        else
+        {
+            EXPECT_EQ(map.lookup(key), key + "-second");
+        }
+    }
+    EXPECT_EQ(map.size(), static_cast<size_t>(num_threads * (keys_per_thread - (keys_per_thread + 2) / 3)));
+}
@@ -0,0 +1,114 @@
+//
+// Created by andreas on 18.10.26.
+//
+#include <thread>
+#include <vector>
+
+#include "./../swiss_lock_free_hash_table.h"
+#include "gtest/gtest.h"
+
+using SwissHashTable = SwissLockFreeHashTable<int32_t, int32_t, -1, -1, 1024>;
+
+namespace
+{
+    // Every key lands in group 0 with the same fingerprint, so lookups have to probe over groups and compare keys
+    struct ConstantHash
+    {
+        size_t operator()(int32_t) const noexcept
+        {
+            return 5;
+        }
+    };
+}
+
+TEST(SwissLockFreeHashTableTest, InsertAndLookupSingleThread)
+{
+    SwissHashTable table;
+    EXPECT_EQ(table.lookup(42), SwissHashTable::no_value);
+    EXPECT_TRUE(table.insert(42, 100));
+    EXPECT_EQ(table.lookup(42), 100);
+
+    // Update existing key
+    EXPECT_TRUE(table.insert(42, 300));
+    EXPECT_EQ(table.lookup(42), 300);
+    EXPECT_EQ(table.lookup(43), SwissHashTable::no_value);
+}
+
+TEST(SwissLockFreeHashTableTest, FullTableRejectsNewKeys)
+{
+    SwissHashTable table;
+    for (int i = 0; i < 1024; ++i)
+    {
+        EXPECT_TRUE(table.insert(i, i * 10));
+    }
+    EXPECT_FALSE(table.insert(2048, 9999));
+    EXPECT_TRUE(table.insert(7, 1));
+    EXPECT_EQ(table.lookup(7), 1);
+    for (int i = 8; i < 1024; ++i)
+    {
+        EXPECT_EQ(table.lookup(i), i * 10);
+    }
+}
+
+TEST(SwissLockFreeHashTableTest, CollidingKeysProbeAcrossGroups)
+{
+    SwissLockFreeHashTable<int32_t, int32_t, -1, -1, 64, ConstantHash> table;
+    for (int i = 0; i < 40; ++i)
+    {
+        EXPECT_TRUE(table.insert(i, i + 1));
+    }
+    for (int i = 0; i < 40; ++i)
+    {
+        EXPECT_EQ(table.lookup(i), i + 1);
+    }
+    EXPECT_EQ(table.lookup(40), -1);
+    EXPECT_EQ(table.probe_length(0), 1u);
+    EXPECT_EQ(table.probe_length(39), 3u);
+}
+
+TEST(SwissLockFreeHashTableTest, ConcurrentInsertsOfSameKeysFillTableExactly)
+{
+    constexpr int num_threads = 8;
+    constexpr int key_count = 2048;
+
+    for (int repeat = 0; repeat < 20; ++repeat)
+    {
+        // One entry per key: a key stored twice would make an insert of another key fail
+        SwissLockFreeHashTable<int32_t, int32_t, -1, -1, key_count> table;
+        std::atomic<bool> inserting{true};
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < num_threads; ++thread)
+        {
+            threads.emplace_back([&table, thread]()
+            {
+                for (int i = 0; i < key_count; ++i)
+                {
+                    int key = (i + thread * 97) % key_count;
+                    EXPECT_TRUE(table.insert(key, key * 10));
+                }
+            });
+        }
+        std::thread reader([&]()
+        {
+            while (inserting.load())
+            {
+                for (int key = 0; key < key_count; ++key)
+                {
+                    auto value = table.lookup(key);
+                    EXPECT_TRUE(value == SwissHashTable::no_value || value == key * 10);
+                }
+            }
+        });
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        inserting.store(false);
+        reader.join();
+
+        for (int key = 0; key < key_count; ++key)
+        {
+            EXPECT_EQ(table.lookup(key), key * 10);
+        }
+    }
+}
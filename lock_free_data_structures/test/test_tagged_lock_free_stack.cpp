@@ -0,0 +1,74 @@
+//
+// Created by andreas on 18.10.26.
+//
+#include "./../tagged_lock_free_stack.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(TaggedLockFreeStackTest, PushPopSingleThread)
+{
+    TaggedLockFreeStack<std::string> stack;
+    EXPECT_TRUE(stack.empty());
+    EXPECT_FALSE(stack.pop().has_value());
+
+    stack.push("a");
+    stack.push("b");
+    EXPECT_FALSE(stack.empty());
+    EXPECT_EQ(stack.pop(), "b");
+    EXPECT_EQ(stack.pop(), "a");
+    EXPECT_TRUE(stack.empty());
+
+    // Nodes left on the stack are destroyed with it
+    stack.push("c");
+}
+
+TEST(TaggedLockFreeStackTest, PoppedNodesAreRecycled)
+{
+    struct CountedNode
+    {
+        std::atomic<CountedNode*> next{nullptr};
+    };
+    TaggedPointerList<CountedNode> list;
+    CountedNode first, second;
+
+    list.push(&first);
+    list.push(&second);
+    EXPECT_EQ(list.pop(), &second);
+    list.push(&second);
+    EXPECT_EQ(list.pop(), &second);
+    EXPECT_EQ(list.pop(), &first);
+    EXPECT_EQ(list.pop(), nullptr);
+}
+
+TEST(TaggedLockFreeStackTest, ConcurrentPushPop)
+{
+    constexpr int kNumThreads = 16;
+    constexpr int kOpsPerThread = 20000;
+
+    TaggedLockFreeStack<int> stack;
+    std::atomic<long long> sum_pop{0};
+
+    // Pushes and pops alternate, so nodes are recycled while other threads still read them
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < kNumThreads; ++thread)
+    {
+        threads.emplace_back([&, thread]()
+        {
+            for (int j = 0; j < kOpsPerThread; ++j)
+            {
+                stack.push(thread * kOpsPerThread + j);
+                auto v = stack.pop();
+                ASSERT_TRUE(v.has_value());
+                sum_pop.fetch_add(v.value(), std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    constexpr long long total = kNumThreads * kOpsPerThread;
+    EXPECT_EQ(sum_pop.load(), total * (total - 1) / 2);
+    EXPECT_TRUE(stack.empty());
+}